@@ -7,6 +7,10 @@
 #include <ArduinoJson.h>
 #include "MFRC522.h"
 #include "NfcAdapter.h"
+#include "CardPresence.h"
+#include "SpotifyNdef.h"
+#include "NdefStream.h"
+#include "UidString.h"
 #include "SpotifyClient.h"
 #include "settings.h"
 
@@ -27,6 +31,9 @@ void logMessage(const String& msg) { logHistory.push_back(msg); if (logHistory.s
 #define SPI_MOSI 7
 MFRC522 mfrc522(SS_PIN, RST_PIN);
 NfcAdapter nfc = NfcAdapter(&mfrc522);
+CardPresence presence(mfrc522);        // New card vs. card still resting on the reader
+NdefStream ndefStream(mfrc522);        // Reads Type 2 tags only as far as the first Spotify URI
+static const unsigned long NFC_POLL_INTERVAL_MS = 50;
 
 // ——— Spotify client ———
 SpotifyClient spotify(clientId, clientSecret, deviceName, refreshToken);
@@ -75,8 +82,11 @@ void loop() {
     currentDeviceId = "";
     wasDisconnected = false;
   }
-  readNFCTag();
-  delay(500);
+  static unsigned long lastPoll = 0;
+  if (millis() - lastPoll >= NFC_POLL_INTERVAL_MS) {
+    lastPoll = millis();
+    readNFCTag();
+  }
 }
 
 // ——— Telnet & Wi-Fi helpers ———
@@ -87,43 +97,37 @@ void logError(const String& msg, int code) { LOG("[Error] " + msg + " (HTTP " +
 
 // ——— NFC tag & NDEF reading ———
 void readNFCTag() {
-    if (!nfc.tagPresent()) { return; }
-    NfcTag tag = nfc.read();
-    LOG("[Main] Tag detected! UID: " + tag.getUidString());
-    if (!tag.hasNdefMessage()) { LOG("[NFC] Tag is not NDEF formatted."); delay(2000); return; }
-    NdefMessage message = tag.getNdefMessage();
-    String finalUri = "";
-    for (int i = 0; i < message.getRecordCount(); i++) {
-        NdefRecord record = message.getRecord(i);
-        if (record.getTnf() == NdefRecord::TNF_WELL_KNOWN && record.getTypeLength() == 1 && record.getType()[0] == 'T') {
-            int payloadLength = record.getPayloadLength();
-            const byte* payload = record.getPayload();
-            int langCodeLength = payload[0] & 0x3F;
-            int textLength = payloadLength - (1 + langCodeLength);
-            char text[textLength + 1];
-            memcpy(text, &payload[1 + langCodeLength], textLength);
-            text[textLength] = '\0';
-            String rawUri = String(text);
-            LOG("[NFC] Found Text Record: " + rawUri);
-
-            String spotifyUri = rawUri;
-            int questionMarkIndex = spotifyUri.indexOf('?');
-            if (questionMarkIndex != -1) {
-                spotifyUri = spotifyUri.substring(0, questionMarkIndex);
-            }
-            if (spotifyUri.startsWith("https://open.spotify.com/")) {
-                spotifyUri.replace("https://open.spotify.com/", "spotify:");
-                int slashIndex = spotifyUri.indexOf('/');
-                if (slashIndex != -1) {
-                    spotifyUri.setCharAt(slashIndex, ':');
-                }
+    CardPresence::Event event = presence.Poll();
+    if (event == CardPresence::REMOVED) { LOG("[NFC] Card removed"); return; }
+    if (event != CardPresence::NEW_CARD) { return; }
+    char finalUri[SpotifyNdef::URI_SIZE] = "";
+    if (MFRC522::PICC_GetType(mfrc522.uid.sak) == MFRC522::PICC_TYPE_MIFARE_UL) {
+        // NTAG and Ultralight: parse while reading and stop at the first Spotify record
+        NdefStream::Result result = ndefStream.FindSpotifyUri(finalUri, sizeof(finalUri));
+        presence.Rest();   // Halted, so it is not read again while it rests on the reader
+        LOG("[Main] Tag detected! UID: " + uidString(mfrc522.uid) + " (" + String(ndefStream.GetBytesRead()) + " bytes read)");
+        if (result == NdefStream::NOT_NDEF) { LOG("[NFC] Tag is not NDEF formatted."); return; }
+        if (result == NdefStream::READ_ERROR) { LOG("[NFC] Read failed, tag removed too early?"); return; }
+    } else {
+        // MIFARE Classic keeps NDEF behind the MAD, which NfcAdapter handles
+        NfcTag tag = nfc.read();
+        presence.Rest();
+        LOG("[Main] Tag detected! UID: " + tag.getUidString());
+        if (!tag.hasNdefMessage()) { LOG("[NFC] Tag is not NDEF formatted."); return; }
+        NdefMessage message = tag.getNdefMessage();
+        // The first record holding a Spotify URI wins. SpotifyNdef reads the payload in place and
+        // bounds every length, so a corrupt record is skipped instead of overrunning the stack.
+        for (int i = 0; i < message.getRecordCount(); i++) {
+            NdefRecord record = message.getRecord(i);
+            if (SpotifyNdef::FromRecord(record.getTnf(), record.getType(), record.getTypeLength(),
+                                        record.getPayload(), record.getPayloadLength(), finalUri, sizeof(finalUri))) {
+                break;
             }
-            if (spotifyUri.startsWith("spotify:")) { finalUri = spotifyUri; break; }
         }
     }
-    if (finalUri.length() > 0) {
-        LOG("[Main] URI ready for playback: " + finalUri);
-        if (finalUri.startsWith("spotify:artist:")) {
+    if (finalUri[0] != '\0') {
+        LOG("[Main] URI ready for playback: " + String(finalUri));
+        if (strncmp(finalUri, "spotify:artist:", 15) == 0) {
             playRandomAlbumFromArtist(finalUri);
         } else {
             playSpotifyUri(finalUri);
@@ -131,7 +135,6 @@ void readNFCTag() {
     } else {
         LOG("[Main] No valid Spotify URI or URL found on this card.");
     }
-    delay(3000);
 }
 
 // ——— Spotify playback helpers ———
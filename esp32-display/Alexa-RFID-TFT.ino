@@ -10,6 +10,7 @@
 #include <algorithm>      // for std::swap
 #include <ArduinoJson.h>
 #include "MFRC522.h"
+#include "CompactUri.h"   // libraries/SpotifyCompactUri, shared with the esp32 sketches
 #include "SpotifyClient.h"
 #include "settings.h"     // your ssid, pass, clientId, clientSecret, deviceName, refreshToken
 
@@ -212,6 +213,7 @@ String readFromCard() {
   String result;
   byte block = 4;
   bool gotData = false;
+  byte head[32];       // Blocks 4 and 5, where a compact URI lives
 
   while (block < 64) {
     if (block % 4 == 3) { block++; continue; } // skip trailers
@@ -222,6 +224,11 @@ String readFromCard() {
     byte size = sizeof(buffer);
     if (mfrc522.MIFARE_Read(block, buffer, &size) != MFRC522::STATUS_OK) break;
 
+    if (block <= 5) {
+      memcpy(head + (block - 4) * 16, buffer, 16);
+      if (block == 5 && CompactUri::Decode(head, sizeof(head), result)) break;
+    }
+
     String chunk;
     for (byte i = 0; i < 16; i++) {
       if (buffer[i] != 0) { chunk += (char)buffer[i]; gotData = true; }
@@ -11,6 +11,10 @@
 #include <ArduinoJson.h>
 #include "MFRC522.h"
 #include "NfcAdapter.h"      // Added for NDEF support
+#include "CardPresence.h"
+#include "SpotifyNdef.h"
+#include "NdefStream.h"
+#include "UidString.h"
 #include "SpotifyClient.h"
 #include "settings.h"
 
@@ -37,6 +41,9 @@ void logMessage(const String& msg) { logHistory.push_back(msg); if (logHistory.s
 #define SS_PIN  5
 MFRC522 mfrc522(SS_PIN, RST_PIN);
 NfcAdapter nfc = NfcAdapter(&mfrc522); // NDEF adapter object
+CardPresence presence(mfrc522);        // New card vs. card still resting on the reader
+NdefStream ndefStream(mfrc522);        // Reads Type 2 tags only as far as the first Spotify URI
+static const unsigned long NFC_POLL_INTERVAL_MS = 50;
 
 // --- Spotify client ---
 SpotifyClient spotify(clientId, clientSecret, deviceName, refreshToken);
@@ -94,7 +101,11 @@ void loop() {
     wasDisconnected = false;
   }
 
-  readNFCTag(); // Replaced the old check with the new function call
+  static unsigned long lastPoll = 0;
+  if (millis() - lastPoll >= NFC_POLL_INTERVAL_MS) {
+    lastPoll = millis();
+    readNFCTag();
+  }
 
   // 30-minute idle → clear screen once
   if (lastArtMillis && millis() - lastArtMillis > 30UL * 60UL * 1000UL) {
@@ -102,8 +113,6 @@ void loop() {
     lastArtMillis = 0;
     LOG("[Main] screen cleared after 30 min");
   }
-
-  delay(500); // Added delay to prevent a tight loop
 }
 
 // --- Telnet & Wi-Fi helpers (Unchanged) ---
@@ -116,48 +125,38 @@ void logError(const String& msg, int code) { LOG("[Error] " + msg + " (HTTP " +
 // --- NEW: NDEF Tag Reading Logic ---
 // This function completely replaces the old readNFCTag, readFromCard, and authenticateBlock functions.
 void readNFCTag() {
-    if (!nfc.tagPresent()) { return; }
-    NfcTag tag = nfc.read();
-    LOG("[Main] Tag detected! UID: " + tag.getUidString());
-    if (!tag.hasNdefMessage()) { LOG("[NFC] Tag is not NDEF formatted."); delay(2000); return; }
-    
-    NdefMessage message = tag.getNdefMessage();
-    String finalUri = "";
-
-    for (int i = 0; i < message.getRecordCount(); i++) {
-        NdefRecord record = message.getRecord(i);
-        // We only care about Text records
-        if (record.getTnf() == NdefRecord::TNF_WELL_KNOWN && record.getTypeLength() == 1 && record.getType()[0] == 'T') {
-            int payloadLength = record.getPayloadLength();
-            const byte* payload = record.getPayload();
-            int langCodeLength = payload[0] & 0x3F;
-            int textLength = payloadLength - (1 + langCodeLength);
-            char text[textLength + 1];
-            memcpy(text, &payload[1 + langCodeLength], textLength);
-            text[textLength] = '\0';
-            String rawUri = String(text);
-            LOG("[NFC] Found Text Record: " + rawUri);
-
-            // Clean the URI to get a standard spotify: format
-            String spotifyUri = rawUri;
-            int questionMarkIndex = spotifyUri.indexOf('?');
-            if (questionMarkIndex != -1) {
-                spotifyUri = spotifyUri.substring(0, questionMarkIndex);
-            }
-             if (spotifyUri.startsWith("https://open.spotify.com/")) {
-                spotifyUri.replace("https://open.spotify.com/", "spotify:");
-                int slashIndex = spotifyUri.indexOf('/');
-                if (slashIndex != -1) {
-                    spotifyUri.setCharAt(slashIndex, ':');
-                }
+    CardPresence::Event event = presence.Poll();
+    if (event == CardPresence::REMOVED) { LOG("[NFC] Card removed"); return; }
+    if (event != CardPresence::NEW_CARD) { return; }
+    char finalUri[SpotifyNdef::URI_SIZE] = "";
+    if (MFRC522::PICC_GetType(mfrc522.uid.sak) == MFRC522::PICC_TYPE_MIFARE_UL) {
+        // NTAG and Ultralight: parse while reading and stop at the first Spotify record
+        NdefStream::Result result = ndefStream.FindSpotifyUri(finalUri, sizeof(finalUri));
+        presence.Rest();   // Halted, so it is not read again while it rests on the reader
+        LOG("[Main] Tag detected! UID: " + uidString(mfrc522.uid) + " (" + String(ndefStream.GetBytesRead()) + " bytes read)");
+        if (result == NdefStream::NOT_NDEF) { LOG("[NFC] Tag is not NDEF formatted."); return; }
+        if (result == NdefStream::READ_ERROR) { LOG("[NFC] Read failed, tag removed too early?"); return; }
+    } else {
+        // MIFARE Classic keeps NDEF behind the MAD, which NfcAdapter handles
+        NfcTag tag = nfc.read();
+        presence.Rest();
+        LOG("[Main] Tag detected! UID: " + tag.getUidString());
+        if (!tag.hasNdefMessage()) { LOG("[NFC] Tag is not NDEF formatted."); return; }
+        NdefMessage message = tag.getNdefMessage();
+        // The first record holding a Spotify URI wins. SpotifyNdef reads the payload in place and
+        // bounds every length, so a corrupt record is skipped instead of overrunning the stack.
+        for (int i = 0; i < message.getRecordCount(); i++) {
+            NdefRecord record = message.getRecord(i);
+            if (SpotifyNdef::FromRecord(record.getTnf(), record.getType(), record.getTypeLength(),
+                                        record.getPayload(), record.getPayloadLength(), finalUri, sizeof(finalUri))) {
+                break;
             }
-            if (spotifyUri.startsWith("spotify:")) { finalUri = spotifyUri; break; }
         }
     }
 
-    if (finalUri.length() > 0) {
-        LOG("[Main] URI ready for playback: " + finalUri);
-        if (finalUri.startsWith("spotify:artist:")) {
+    if (finalUri[0] != '\0') {
+        LOG("[Main] URI ready for playback: " + String(finalUri));
+        if (strncmp(finalUri, "spotify:artist:", 15) == 0) {
             playRandomAlbumFromArtist(finalUri);
         } else {
             playSpotifyUri(finalUri);
@@ -165,7 +164,6 @@ void readNFCTag() {
     } else {
         LOG("[Main] No valid Spotify URI or URL found on this card.");
     }
-    delay(3000); // Wait a few seconds before allowing another scan
 }
 
 
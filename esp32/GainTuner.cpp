@@ -0,0 +1,82 @@
+#include "GainTuner.h"
+
+static const byte GAINS[GainTuner::GAIN_COUNT] = {
+    MFRC522::RxGain_18dB, MFRC522::RxGain_23dB, MFRC522::RxGain_33dB,
+    MFRC522::RxGain_38dB, MFRC522::RxGain_43dB, MFRC522::RxGain_48dB
+};
+
+GainTuner::GainTuner(MFRC522& reader) : mfrc522(reader) {}
+
+bool GainTuner::Begin() {
+    started = prefs.begin("rfid", false);
+    bool stored = started && prefs.isKey("gain");
+    if (stored) {
+        gain = prefs.getUChar("gain", gain);
+    }
+    Apply();
+    return stored;
+}
+
+void GainTuner::Apply() {
+    mfrc522.PCD_SetAntennaGain(gain);
+}
+
+bool GainTuner::Calibrate(const MFRC522::MIFARE_Key& key, byte trials) {
+    MFRC522::Uid uid = mfrc522.uid;
+    mfrc522.PICC_HaltA();                           // Every trial starts from a halted card, like a real tap
+
+    this->trials = trials;
+    best = 0;
+    for (byte g = 0; g < GAIN_COUNT; g++) {
+        mfrc522.PCD_SetAntennaGain(GAINS[g]);
+        byte successes = 0;
+        unsigned long total = 0;
+        for (byte i = 0; i < trials; i++) {
+            unsigned long t;
+            if (Trial(uid, key, t)) {
+                successes++;
+                total += t;
+            }
+        }
+        Result& r = results[g];
+        r.gain = GAINS[g];
+        r.successes = successes;
+        r.meanMicros = successes ? total / successes : 0;
+        const Result& b = results[best];
+        if (r.successes > b.successes || (r.successes == b.successes && r.successes > 0 && r.meanMicros < b.meanMicros)) {
+            best = g;
+        }
+    }
+
+    if (results[best].successes == 0) {             // No gain could read the card, keep the current one
+        Apply();
+        return false;
+    }
+    gain = results[best].gain;
+    Apply();
+    if (started) {
+        prefs.putUChar("gain", gain);
+    }
+    return true;
+}
+
+// One tap: wake and select the card, then read its first data block. Any retry counts as a failure.
+bool GainTuner::Trial(const MFRC522::Uid& uid, const MFRC522::MIFARE_Key& key, unsigned long& elapsed) {
+    byte buffer[18];
+    byte size = sizeof(buffer);
+    unsigned long start = micros();
+
+    bool ok = mfrc522.PICC_WakeupAndSelect(&uid) == MFRC522::STATUS_OK;
+    if (ok && MFRC522::PICC_GetType(uid.sak) == MFRC522::PICC_TYPE_MIFARE_UL) {
+        ok = mfrc522.MIFARE_Read(4, buffer, &size) == MFRC522::STATUS_OK;         // First user page
+    } else if (ok) {
+        ok = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 1, const_cast<MFRC522::MIFARE_Key*>(&key),
+                                      const_cast<MFRC522::Uid*>(&uid)) == MFRC522::STATUS_OK &&
+             mfrc522.MIFARE_Read(1, buffer, &size) == MFRC522::STATUS_OK;
+    }
+    elapsed = micros() - start;
+
+    mfrc522.PICC_HaltA();
+    mfrc522.PCD_StopCrypto1();
+    return ok;
+}
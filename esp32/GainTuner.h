@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "MFRC522.h"
+
+// Picks the RC522 receiver gain (RxGain in RFCfgReg) for the card stock and enclosure in use.
+// Calibrate() tries every distinct gain on the card in the field and keeps the one with the most
+// first-try reads, then the fastest. The result is stored in NVS and applied again on every boot.
+// Nothing is printed; the caller logs GetResult() of each gain after Calibrate().
+class GainTuner {
+public:
+    static const byte GAIN_COUNT = 6;               // Distinct RxGain settings tried by Calibrate()
+
+    struct Result {
+        byte gain;                                  // RxGain mask
+        byte successes;                             // First-try reads out of GetTrials()
+        unsigned long meanMicros;                   // Mean time of those reads, 0 if there were none
+    };
+
+    GainTuner(MFRC522& reader);
+
+    bool Begin();       // Loads the stored gain, if any, and applies it. Returns true if a stored gain was found
+    void Apply();       // Writes the gain to the reader again, e.g. after PCD_Init() reset it
+
+    // Needs a selected card (reader.uid valid). Each gain gets trials reads of the first data block,
+    // with the card woken and selected again every time. Returns false if no gain read the card at all.
+    bool Calibrate(const MFRC522::MIFARE_Key& key, byte trials = 20);
+
+    byte GetGain() const { return gain; }           // RxGain mask, one of MFRC522::PCD_RxGain
+    byte GetTrials() const { return trials; }       // Reads per gain in the last Calibrate()
+    const Result& GetResult(byte index) const { return results[index]; }   // index < GAIN_COUNT, from the last Calibrate()
+    const Result& GetBest() const { return results[best]; }               // The picked gain's result
+
+private:
+    MFRC522& mfrc522;
+    Preferences prefs;
+    bool started = false;
+    byte gain = MFRC522::RxGain_avg;                // Reset value of RFCfgReg, 33 dB
+    byte trials = 0;
+    byte best = 0;                                  // Index into results
+    Result results[GAIN_COUNT] = {};
+
+    bool Trial(const MFRC522::Uid& uid, const MFRC522::MIFARE_Key& key, unsigned long& elapsed);
+};
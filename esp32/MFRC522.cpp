@@ -7,6 +7,43 @@
 #include <Arduino.h>
 #include "MFRC522.h"
 
+// Lookup table for CRC_A (ISO/IEC 14443-3 annex B): CRC-16/CCITT, reflected polynomial 0x8408.
+// Entry i is the CRC register after shifting in byte i with a zero register.
+static constexpr uint16_t CRC_A_TABLE[256] = {
+	0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+	0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+	0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+	0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+	0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+	0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+	0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+	0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+	0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+	0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+	0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+	0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+	0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+	0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+	0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+	0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+	0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+	0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+	0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+	0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+	0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+	0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+	0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+	0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+	0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+	0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+	0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+	0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+	0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+	0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+	0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+	0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78
+};
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for setting up the Arduino
 /////////////////////////////////////////////////////////////////////////////////////
@@ -30,9 +67,33 @@ MFRC522::MFRC522(	byte resetPowerDownPin	///< Arduino pin connected to MFRC522's
  */
 MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
 					byte resetPowerDownPin	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low). If there is no connection from the CPU to NRSTPD, set this to UINT8_MAX. In this case, only soft reset will be used in PCD_Init().
-				) {
-	_chipSelectPin = chipSelectPin;
+				) : _spiTransport(chipSelectPin, MFRC522_SPICLOCK) {
+	_transport = &_spiTransport;
 	_resetPowerDownPin = resetPowerDownPin;
+	_spiClock = MFRC522_SPICLOCK;
+	_regQueueLength = 0;
+	_shadowValid = 0;
+	_shadowHits = 0;
+	memset(&_errors, 0, sizeof(_errors));
+	_hasDeadline = false;
+	_deadline = 0;
+#if MFRC522_ENABLE_TRACE
+	_trace = nullptr;
+#endif
+	_irqPin = UNUSED_PIN;
+#if defined(ESP32)
+	_irqSemaphore = nullptr;
+#endif
+} // End constructor
+
+/**
+ * Constructor for a MFRC522 on another bus than the default SPI, see MFRC522Transport.h.
+ * The transport must outlive this object.
+ */
+MFRC522::MFRC522(	MFRC522Transport &transport,	///< Bus the MFRC522 is on
+					byte resetPowerDownPin			///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low), or UNUSED_PIN.
+				): MFRC522(UNUSED_PIN, resetPowerDownPin) {
+	_transport = &transport;
 } // End constructor
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -46,12 +107,13 @@ MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's S
 void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to. One of the PCD_Register enums.
 									byte value			///< The value to write.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
-	SPI.transfer(value);
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	if (!PCD_ShadowWrite(reg, value)) {
+		return;								// The register already holds this value
+	}
+#if MFRC522_ENABLE_TRACE
+	if (_trace) _trace->Record(micros(), reg, false, 1, &value);
+#endif
+	_transport->WriteRegister(reg, 1, &value);
 } // End PCD_WriteRegister()
 
 /**
@@ -62,14 +124,14 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 									byte count,			///< The number of bytes to write to the register
 									byte *values		///< The values to write. Byte array.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
-	for (byte index = 0; index < count; index++) {
-		SPI.transfer(values[index]);
-	}
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	if (count > 0 && PCD_IsShadowed(reg)) {
+		_shadow[reg >> 1] = values[count - 1];	// The register keeps the last byte written
+		_shadowValid |= (uint64_t)1 << (reg >> 1);
+	}
+#if MFRC522_ENABLE_TRACE
+	if (_trace) _trace->Record(micros(), reg, false, count, values);
+#endif
+	_transport->WriteRegister(reg, count, values);
 } // End PCD_WriteRegister()
 
 /**
@@ -79,12 +141,22 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 byte MFRC522::PCD_ReadRegister(	PCD_Register reg	///< The register to read from. One of the PCD_Register enums.
 								) {
 	byte value;
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);			// Select slave
-	SPI.transfer(0x80 | reg);					// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
-	value = SPI.transfer(0);					// Read the value back. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	const bool shadowed = PCD_IsShadowed(reg);
+	if (shadowed && (_shadowValid & ((uint64_t)1 << (reg >> 1)))) {
+		_shadowHits++;
+		return _shadow[reg >> 1];				// Only the PCD changes this register, the copy is current
+	}
+#if MFRC522_ENABLE_TRACE
+	const uint32_t start = micros();
+#endif
+	_transport->ReadRegister(reg, 1, &value);
+#if MFRC522_ENABLE_TRACE
+	if (_trace) _trace->Record(start, reg, true, 1, &value);
+#endif
+	if (shadowed) {
+		_shadow[reg >> 1] = value;
+		_shadowValid |= (uint64_t)1 << (reg >> 1);
+	}
 	return value;
 } // End PCD_ReadRegister()
 
@@ -100,29 +172,20 @@ void MFRC522::PCD_ReadRegister(	PCD_Register reg,	///< The register to read from
 	if (count == 0) {
 		return;
 	}
-	//Serial.print(F("Reading ")); 	Serial.print(count); Serial.println(F(" bytes from register."));
-	byte address = 0x80 | reg;				// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
-	byte index = 0;							// Index in values array.
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	count--;								// One read is performed outside of the loop
-	SPI.transfer(address);					// Tell MFRC522 which address we want to read
+	byte first = values[0];
+#if MFRC522_ENABLE_TRACE
+	const uint32_t start = micros();
+#endif
+	_transport->ReadRegister(reg, count, values);
+#if MFRC522_ENABLE_TRACE
+	if (_trace) _trace->Record(start, reg, true, count, values);
+#endif
 	if (rxAlign) {		// Only update bit positions rxAlign..7 in values[0]
 		// Create bit mask for bit positions rxAlign..7
 		byte mask = (0xFF << rxAlign) & 0xFF;
-		// Read value and tell that we want to read the same address again.
-		byte value = SPI.transfer(address);
-		// Apply mask to both current value of values[0] and the new data in value.
-		values[0] = (values[0] & ~mask) | (value & mask);
-		index++;
-	}
-	while (index < count) {
-		values[index] = SPI.transfer(address);	// Read value and tell that we want to read the same address again.
-		index++;
-	}
-	values[index] = SPI.transfer(0);			// Read the final byte. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+		// Apply mask to both the previous value of values[0] and the new data.
+		values[0] = (first & ~mask) | (values[0] & mask);
+	}
 } // End PCD_ReadRegister()
 
 /**
@@ -147,9 +210,136 @@ void MFRC522::PCD_ClearRegisterBitMask(	PCD_Register reg,	///< The register to u
 	PCD_WriteRegister(reg, tmp & (~mask));		// clear bit mask
 } // End PCD_ClearRegisterBitMask()
 
+/**
+ * Returns true for the configuration registers that are kept in the shadow.
+ * These registers only change when the PCD writes them (or on reset), so a local
+ * copy can answer reads and detect writes that would not change anything.
+ * Status, FIFO, command and IRQ request registers are never shadowed.
+ */
+bool MFRC522::PCD_IsShadowed(	PCD_Register reg	///< The register to check. One of the PCD_Register enums.
+							) {
+	static constexpr uint64_t shadowedRegisters =
+		(1ULL << (ComIEnReg >> 1))		| (1ULL << (DivIEnReg >> 1))		|
+		(1ULL << (ModeReg >> 1))		| (1ULL << (TxModeReg >> 1))		| (1ULL << (RxModeReg >> 1))		|
+		(1ULL << (TxControlReg >> 1))	| (1ULL << (TxASKReg >> 1))			| (1ULL << (TxSelReg >> 1))			|
+		(1ULL << (RxSelReg >> 1))		| (1ULL << (RxThresholdReg >> 1))	| (1ULL << (DemodReg >> 1))			|
+		(1ULL << (MfTxReg >> 1))		| (1ULL << (MfRxReg >> 1))			| (1ULL << (ModWidthReg >> 1))		|
+		(1ULL << (RFCfgReg >> 1))		| (1ULL << (GsNReg >> 1))			| (1ULL << (CWGsPReg >> 1))			|
+		(1ULL << (ModGsPReg >> 1))		| (1ULL << (TModeReg >> 1))			| (1ULL << (TPrescalerReg >> 1))	|
+		(1ULL << (TReloadRegH >> 1))	| (1ULL << (TReloadRegL >> 1));
+	return (shadowedRegisters >> (reg >> 1)) & 1;
+} // End PCD_IsShadowed()
 
 /**
- * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ * Updates the shadow for a single byte register write.
+ * 
+ * @return false if the register is shadowed and already holds value, ie the write can be skipped. true otherwise.
+ */
+bool MFRC522::PCD_ShadowWrite(	PCD_Register reg,	///< The register that is written. One of the PCD_Register enums.
+								byte value			///< The value that is written.
+							) {
+	if (!PCD_IsShadowed(reg)) {
+		return true;
+	}
+	const uint64_t bit = (uint64_t)1 << (reg >> 1);
+	if ((_shadowValid & bit) && _shadow[reg >> 1] == value) {
+		_shadowHits++;
+		return false;
+	}
+	_shadow[reg >> 1] = value;
+	_shadowValid |= bit;
+	return true;
+} // End PCD_ShadowWrite()
+
+/**
+ * Forgets all shadowed register values. The next access to each register goes to the chip again.
+ * Called on every reset. Call it yourself if something else than this instance may have changed the registers.
+ */
+void MFRC522::PCD_InvalidateShadow() {
+	_shadowValid = 0;
+} // End PCD_InvalidateShadow()
+
+/**
+ * Returns how many register reads and writes were answered by the shadow instead of an SPI transaction.
+ * 
+ * @return Number of SPI transactions saved since construction.
+ */
+uint32_t MFRC522::PCD_GetShadowHitCount() {
+	return _shadowHits;
+} // End PCD_GetShadowHitCount()
+
+/**
+ * Queues a write of one byte to the specified register in the MFRC522 chip.
+ * Nothing is sent until PCD_FlushRegisterQueue() is called.
+ */
+void MFRC522::PCD_QueueRegisterWrite(	PCD_Register reg,	///< The register to write to. One of the PCD_Register enums.
+										byte value			///< The value to write.
+									) {
+	PCD_QueueRegisterWrite(reg, 1, &value);
+} // End PCD_QueueRegisterWrite()
+
+/**
+ * Queues a write of a number of bytes to the specified register in the MFRC522 chip.
+ * Nothing is sent until PCD_FlushRegisterQueue() is called. The values are copied, so the
+ * caller may reuse the buffer right away.
+ * If the queue is full it is flushed first. A write that does not fit in an empty queue is sent directly.
+ */
+void MFRC522::PCD_QueueRegisterWrite(	PCD_Register reg,	///< The register to write to. One of the PCD_Register enums.
+										byte count,			///< The number of bytes to write to the register
+										byte *values		///< The values to write. Byte array.
+									) {
+	if (count == 0) {
+		return;
+	}
+	if ((uint16_t)count + 2 > REG_QUEUE_SIZE) {		// Never fits, keep ordering and send it directly
+		PCD_FlushRegisterQueue();
+		PCD_WriteRegister(reg, count, values);
+		return;
+	}
+	if (count == 1 && !PCD_ShadowWrite(reg, values[0])) {
+		return;										// The register already holds this value
+	}
+	if (count > 1 && PCD_IsShadowed(reg)) {
+		_shadow[reg >> 1] = values[count - 1];
+		_shadowValid |= (uint64_t)1 << (reg >> 1);
+	}
+	if ((uint16_t)_regQueueLength + count + 2 > REG_QUEUE_SIZE) {
+		PCD_FlushRegisterQueue();
+	}
+	_regQueue[_regQueueLength++] = count + 1;		// Frame length: address byte + data
+	_regQueue[_regQueueLength++] = reg;				// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
+	memcpy(&_regQueue[_regQueueLength], values, count);
+	_regQueueLength += count;
+} // End PCD_QueueRegisterWrite()
+
+/**
+ * Sends all queued register writes inside a single bus transaction.
+ * The MFRC522 applies all data bytes of one NSS frame to the same address (datasheet section 8.1.2.2),
+ * so each register still gets its own chip select pulse. What is saved is the per-write
+ * beginTransaction()/endTransaction() and the byte-by-byte transfer calls; each frame is
+ * handed to the bus driver as one buffer. See MFRC522Transport::WriteFrames().
+ */
+void MFRC522::PCD_FlushRegisterQueue() {
+	if (_regQueueLength == 0) {
+		return;
+	}
+#if MFRC522_ENABLE_TRACE
+	if (_trace) {
+		const uint32_t start = micros();
+		for (byte index = 0; index < _regQueueLength; index += _regQueue[index] + 1) {
+			_trace->Record(start, _regQueue[index + 1], false, _regQueue[index] - 1, &_regQueue[index + 2]);
+		}
+	}
+#endif
+	_transport->WriteFrames(_regQueue, _regQueueLength);	// The queue is not needed anymore, so it may be overwritten
+	_regQueueLength = 0;
+} // End PCD_FlushRegisterQueue()
+
+
+/**
+ * Calculates a CRC_A.
+ * With MFRC522_SOFTWARE_CRC set (the default) this is done by CalculateCRC_A() on the host CPU.
+ * Otherwise the CRC coprocessor in the MFRC522 is used.
  * 
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -157,17 +347,28 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 												byte length,	///< In: The number of bytes to transfer.
 												byte *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
 					 ) {
-	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop any active command.
-	PCD_WriteRegister(DivIrqReg, 0x04);				// Clear the CRCIRq interrupt request bit
-	PCD_WriteRegister(FIFOLevelReg, 0x80);			// FlushBuffer = 1, FIFO initialization
-	PCD_WriteRegister(FIFODataReg, length, data);	// Write data to the FIFO
-	PCD_WriteRegister(CommandReg, PCD_CalcCRC);		// Start the calculation
-	
-	// Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73μs.
-	// TODO check/modify for other architectures than Arduino Uno 16bit
-
-	// Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73us.
-	for (uint16_t i = 5000; i > 0; i--) {
+#if MFRC522_SOFTWARE_CRC
+	CalculateCRC_A(data, length, result);
+	return STATUS_OK;
+#else
+	PCD_QueueRegisterWrite(CommandReg, PCD_Idle);		// Stop any active command.
+	PCD_QueueRegisterWrite(DivIrqReg, 0x04);			// Clear the CRCIRq interrupt request bit
+	if (_irqPin != UNUSED_PIN) {
+		PCD_ClearIrq();
+		PCD_QueueRegisterWrite(ComIEnReg, 0x80);		// IRqInv=1 => IRQ pin is active low. No ComIrqReg sources.
+		PCD_QueueRegisterWrite(DivIEnReg, 0x80 | 0x04);	// IRQPushPull=1, CRCIEn=1
+	}
+	PCD_QueueRegisterWrite(FIFOLevelReg, 0x80);			// FlushBuffer = 1, FIFO initialization
+	PCD_QueueRegisterWrite(FIFODataReg, length, data);	// Write data to the FIFO
+	PCD_QueueRegisterWrite(CommandReg, PCD_CalcCRC);	// Start the calculation
+	PCD_FlushRegisterQueue();							// Send the whole setup in one bus transaction
+	
+	// Wait for the CRC calculation to complete. 89ms without CRCIRq means the MFRC522 itself is stuck.
+	// The bound is wall-clock time, because one DivIrqReg read takes anything from 17.73μs on an Arduino Uno
+	// to a few μs at 10MHz SPI. In IRQ mode the loop sleeps until the IRQ pin fires instead of reading DivIrqReg over and over.
+	const uint32_t start = millis();
+	for (;;) {
+		uint32_t elapsed = millis() - start;	// Taken before the read, so a task switch in between cannot cut the wait short
 		// DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
 		byte n = PCD_ReadRegister(DivIrqReg);
 		if (n & 0x04) {									// CRCIRq bit set - calculation done
@@ -177,11 +378,34 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 			result[1] = PCD_ReadRegister(CRCResultRegH);
 			return STATUS_OK;
 		}
+		if (elapsed >= 89) {
+			break;
+		}
+		if (_irqPin != UNUSED_PIN) {
+			PCD_WaitForIrq(89 - elapsed);
+		}
 	}
 	// 89ms passed and nothing happend. Communication with the MFRC522 might be down.
 	return STATUS_TIMEOUT;
+#endif
 } // End PCD_CalculateCRC()
 
+/**
+ * Calculates a CRC_A in software, using the same preset (0x6363) as PCD_Init() programs into the CRC coprocessor.
+ * Gives the same result as the coprocessor, without any SPI traffic.
+ */
+void MFRC522::CalculateCRC_A(	const byte *data,	///< In: Pointer to the data to calculate the CRC_A for.
+								byte length,		///< In: The number of bytes in data.
+								byte *result		///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
+							) {
+	uint16_t crc = 0x6363;
+	for (byte i = 0; i < length; i++) {
+		crc = (crc >> 8) ^ CRC_A_TABLE[(crc ^ data[i]) & 0xFF];
+	}
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+} // End CalculateCRC_A()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for manipulating the MFRC522
@@ -193,9 +417,9 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 void MFRC522::PCD_Init() {
 	bool hardReset = false;
 
-	// Set the chipSelectPin as digital output, do not select the slave yet
-	pinMode(_chipSelectPin, OUTPUT);
-	digitalWrite(_chipSelectPin, HIGH);
+	PCD_InvalidateShadow();		// The chip may have been reset or power cycled since we last saw it
+
+	_transport->Begin();		// For SPI: set the chipSelectPin as digital output, do not select the slave yet
 	
 	// If a valid pin number has been set, pull device out of power down / reset state.
 	if (_resetPowerDownPin != UNUSED_PIN) {
@@ -228,8 +452,8 @@ void MFRC522::PCD_Init() {
 	// TPrescaler_Hi are the four low bits in TModeReg. TPrescaler_Lo is TPrescalerReg.
 	PCD_WriteRegister(TModeReg, 0x80);			// TAuto=1; timer starts automatically at the end of the transmission in all communication modes at all speeds
 	PCD_WriteRegister(TPrescalerReg, 0xA9);		// TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25μs.
-	PCD_WriteRegister(TReloadRegH, 0x03);		// Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
-	PCD_WriteRegister(TReloadRegL, 0xE8);
+	PCD_WriteRegister(TReloadRegH, TIMEOUT_DEFAULT >> 8);	// Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
+	PCD_WriteRegister(TReloadRegL, TIMEOUT_DEFAULT & 0xFF);	// PCD_CommunicateWithPICC() shortens it for commands that are answered quickly.
 	
 	PCD_WriteRegister(TxASKReg, 0x40);		// Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
 	PCD_WriteRegister(ModeReg, 0x3D);		// Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
@@ -250,9 +474,9 @@ void MFRC522::PCD_Init(	byte resetPowerDownPin	///< Arduino pin connected to MFR
 void MFRC522::PCD_Init(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
 						byte resetPowerDownPin	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
 					) {
-	_chipSelectPin = chipSelectPin;
+	_spiTransport.SetChipSelectPin(chipSelectPin);
+	_transport = &_spiTransport;
 	_resetPowerDownPin = resetPowerDownPin; 
-	// Set the chipSelectPin as digital output, do not select the slave yet
 	PCD_Init();
 } // End PCD_Init()
 
@@ -261,6 +485,7 @@ void MFRC522::PCD_Init(	byte chipSelectPin,		///< Arduino pin connected to MFRC5
  */
 void MFRC522::PCD_Reset() {
 	PCD_WriteRegister(CommandReg, PCD_SoftReset);	// Issue the SoftReset command.
+	PCD_InvalidateShadow();							// All registers go back to their reset values
 	// The datasheet does not mention how long the SoftRest command takes to complete.
 	// But the MFRC522 might have been in soft power-down mode (triggered by bit 4 of CommandReg) 
 	// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74μs. Let us be generous: 50ms.
@@ -339,8 +564,11 @@ bool MFRC522::PCD_PerformSelfTest() {
 	PCD_WriteRegister(CommandReg, PCD_CalcCRC);
 	
 	// 6. Wait for self-test to complete
+	// Bounded by wall-clock time rather than by a number of reads, so a faster SPI clock (see PCD_CalibrateSPIClock())
+	// does not give up before the test is done.
 	byte n;
-	for (uint8_t i = 0; i < 0xFF; i++) {
+	const uint32_t start = millis();
+	while (millis() - start < 20) {
 		// The datasheet does not specify exact completion condition except
 		// that FIFO buffer should contain 64 bytes.
 		// While selftest is initiated by CalcCRC command
@@ -396,6 +624,279 @@ bool MFRC522::PCD_PerformSelfTest() {
 	return true;
 } // End PCD_PerformSelfTest()
 
+/**
+ * Writes a test pattern to the 64 byte FIFO and reads it back.
+ * Catches a SPI clock that is too fast for the wiring, which the version register alone does not.
+ * The FIFO is flushed before and after the test.
+ * 
+ * @return Whether all 64 bytes came back unchanged.
+ */
+bool MFRC522::PCD_PerformFIFOLoopbackTest() {
+	byte pattern[FIFO_SIZE];
+	byte readBack[FIFO_SIZE];
+	for (byte i = 0; i < FIFO_SIZE; i++) {
+		// Alternating bits and a counter, so stuck, shifted and swapped bits all show up
+		pattern[i] = (i & 1) ? (0xAA ^ i) : (0x55 ^ i);
+	}
+	
+	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
+	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
+	PCD_WriteRegister(FIFODataReg, FIFO_SIZE, pattern);	// Fill the FIFO
+	bool passed = (PCD_ReadRegister(FIFOLevelReg) & 0x7F) == FIFO_SIZE;
+	if (passed) {
+		PCD_ReadRegister(FIFODataReg, FIFO_SIZE, readBack, 0);
+		passed = memcmp(pattern, readBack, FIFO_SIZE) == 0;
+	}
+	PCD_WriteRegister(FIFOLevelReg, 0x80);				// Leave an empty FIFO behind
+	return passed;
+} // End PCD_PerformFIFOLoopbackTest()
+
+/**
+ * Sets the SPI clock used for all communication with the MFRC522.
+ * The MFRC522 accepts up to 10MHz, but long cables may need less. See PCD_CalibrateSPIClock().
+ */
+void MFRC522::PCD_SetSPIClock(uint32_t clock	///< SPI clock in Hz.
+							) {
+	_spiClock = clock;
+	_transport->SetClock(clock);
+} // End PCD_SetSPIClock()
+
+/**
+ * Returns the SPI clock used for all communication with the MFRC522.
+ * 
+ * @return SPI clock in Hz.
+ */
+uint32_t MFRC522::PCD_GetSPIClock() {
+	return _spiClock;
+} // End PCD_GetSPIClock()
+
+/**
+ * Finds the fastest SPI clock that works reliably with the current wiring.
+ * 
+ * Steps the clock up from 1MHz to maxClock. At each step PCD_PerformSelfTest() and
+ * PCD_PerformFIFOLoopbackTest() must pass several times in a row. The search stops at
+ * the first step that fails, and the last passing clock is kept. Chips without self-test
+ * reference data (clones) are checked with the FIFO loopback and the version register only.
+ * 
+ * The self-test resets the chip, so PCD_Init() is called again at the end.
+ * Store the result (e.g. in NVS) and hand it to PCD_SetSPIClock() on the next boot.
+ * 
+ * @return The selected SPI clock in Hz, or 0 if not even the slowest step worked. In that case the previous clock is kept.
+ */
+uint32_t MFRC522::PCD_CalibrateSPIClock(uint32_t maxClock	///< Upper limit in Hz. Default 10MHz, the limit from the datasheet.
+										) {
+	static const uint32_t steps[] = { 1000000u, 2000000u, 4000000u, 5000000u, 6666666u, 8000000u, 10000000u };
+	const byte rounds = 3;					// Passes needed at each step
+	const uint32_t previousClock = _spiClock;
+	uint32_t best = 0;
+	byte version = 0;
+	bool selfTestUsable = false;
+	
+	for (byte step = 0; step < sizeof(steps) / sizeof(steps[0]) && steps[step] <= maxClock; step++) {
+		PCD_SetSPIClock(steps[step]);
+		bool passed = true;
+		for (byte round = 0; round < rounds && passed; round++) {
+			if (step == 0 && round == 0) {
+				// Learn what a good answer looks like at the slowest clock
+				version = PCD_ReadRegister(VersionReg);
+				selfTestUsable = PCD_PerformSelfTest();
+				passed = version != 0x00 && version != 0xFF;
+			}
+			else {
+				passed = PCD_ReadRegister(VersionReg) == version;
+				if (passed && selfTestUsable) {
+					passed = PCD_PerformSelfTest();
+				}
+			}
+			passed = passed && PCD_PerformFIFOLoopbackTest();
+		}
+		if (!passed) {
+			break;
+		}
+		best = steps[step];
+	}
+	
+	PCD_SetSPIClock(best ? best : previousClock);
+	PCD_Init();								// The self-test left the chip reset
+	return best;
+} // End PCD_CalibrateSPIClock()
+
+/**
+ * Switches to interrupt driven waiting. Needs the IRQ pin of the module connected to irqPin.
+ * 
+ * PCD_CommunicateWithPICC() and PCD_CalculateCRC() then enable the completion interrupts
+ * in ComIEnReg/DivIEnReg and sleep until the IRQ pin goes low, instead of reading
+ * ComIrqReg/DivIrqReg over SPI in a tight loop. On ESP32 the waiting task blocks on a
+ * semaphore, so the other tasks on that core (Wi-Fi, TLS) keep running meanwhile.
+ * Only implemented for ESP32. On other architectures the call is ignored and the library keeps polling.
+ * Call after PCD_Init().
+ */
+void MFRC522::PCD_EnableIrq(byte irqPin	///< Arduino pin connected to MFRC522's interrupt request output (Pin 23, IRQ).
+							) {
+	PCD_DisableIrq();
+#if defined(ESP32)
+	if (_irqSemaphore == nullptr) {
+		_irqSemaphore = xSemaphoreCreateBinary();
+		if (_irqSemaphore == nullptr) {
+			return; // Out of memory, stay in polling mode
+		}
+	}
+	// The pin is driven push-pull by the MFRC522 (DivIEnReg IRQPushPull=1), no pull-up needed.
+	pinMode(irqPin, INPUT);
+	PCD_WriteRegister(ComIEnReg, 0x80);		// IRqInv=1 => IRQ pin is active low. All sources disabled until a command is started.
+	PCD_WriteRegister(DivIEnReg, 0x80);		// IRQPushPull=1
+	PCD_WriteRegister(ComIrqReg, 0x7F);		// Clear all interrupt request bits so the pin idles high
+	PCD_WriteRegister(DivIrqReg, 0x14);
+	_irqPin = irqPin;
+	attachInterruptArg(digitalPinToInterrupt(irqPin), PCD_IrqHandler, this, FALLING);
+#else
+	(void)irqPin;
+#endif
+} // End PCD_EnableIrq()
+
+/**
+ * Goes back to polling ComIrqReg/DivIrqReg over SPI and releases the IRQ pin.
+ */
+void MFRC522::PCD_DisableIrq() {
+	if (_irqPin == UNUSED_PIN) {
+		return;
+	}
+	detachInterrupt(digitalPinToInterrupt(_irqPin));
+	_irqPin = UNUSED_PIN;
+	PCD_WriteRegister(ComIEnReg, 0x80);		// Reset values
+	PCD_WriteRegister(DivIEnReg, 0x00);
+} // End PCD_DisableIrq()
+
+/**
+ * Checks that the MFRC522 still answers, and resets it if it does not.
+ * A chip that lost power or a loose wire reads VersionReg as 0x00 or 0xFF. Commands then end in
+ * STATUS_TIMEOUT forever, counted in PCD_ErrorCounters::chipTimeouts.
+ * With selfTest the digital self-test of section 16.1.1 runs as well. It takes about 50ms and resets the chip, so
+ * PCD_Init() is called again afterwards. Chips without a firmware reference (most clones) skip the self-test.
+ * 
+ * Register settings made after PCD_Init(), like the antenna gain, must be applied again whenever the chip was
+ * reset, that is after a self-test or when false is returned.
+ * 
+ * @return true if the chip answered (and passed the self-test), false if PCD_Recover() had to reset it.
+ */
+bool MFRC522::PCD_CheckHealth(	bool selfTest	///< True => also run PCD_PerformSelfTest()
+							) {
+	byte version = PCD_ReadRegister(VersionReg);
+	bool healthy = (version != 0x00 && version != 0xFF);
+	bool hasReference = (version == 0x88 || (version >= 0x90 && version <= 0x92));
+	if (healthy && selfTest && hasReference) {
+		healthy = PCD_PerformSelfTest();
+		PCD_Init();							// The self-test left the chip reset
+	}
+	if (!healthy) {
+		PCD_Recover();
+	}
+	return healthy;
+} // End PCD_CheckHealth()
+
+/**
+ * Resets the MFRC522 and initializes it again.
+ * Uses a hard reset through NRSTPD when the pin is connected, since a chip that stopped answering on SPI
+ * will not see the SoftReset command either.
+ */
+void MFRC522::PCD_Recover() {
+	_errors.recoveries++;
+	if (_resetPowerDownPin != UNUSED_PIN) {
+		pinMode(_resetPowerDownPin, OUTPUT);
+		digitalWrite(_resetPowerDownPin, LOW);
+		delayMicroseconds(2);				// 8.8.1 Reset timing requirements says about 100ns
+		digitalWrite(_resetPowerDownPin, HIGH);
+		delay(50);							// Oscillator start-up, see PCD_Init()
+	}
+	else {
+		PCD_Reset();
+	}
+	PCD_Init();
+} // End PCD_Recover()
+
+/**
+ * Returns the error counters. They are never reset by the library, so a caller can compare two snapshots.
+ * 
+ * @return Counters since construction or the last PCD_ResetErrorCounters().
+ */
+const MFRC522::PCD_ErrorCounters &MFRC522::PCD_GetErrorCounters() const {
+	return _errors;
+} // End PCD_GetErrorCounters()
+
+/**
+ * Sets all error counters to zero.
+ */
+void MFRC522::PCD_ResetErrorCounters() {
+	memset(&_errors, 0, sizeof(_errors));
+} // End PCD_ResetErrorCounters()
+
+/**
+ * Sets a time no PICC command may run past, e.g. the end of a time slot shared with other readers.
+ * Until PCD_ClearDeadline(), PCD_CommunicateWithPICC() shortens the timer and its own wait to the time left,
+ * and does not start a command once the deadline has passed. Such commands end in STATUS_TIMEOUT
+ * and count in PCD_ErrorCounters::deadlines.
+ */
+void MFRC522::PCD_SetDeadline(uint32_t deadline	///< millis() value, at most 24 days ahead
+							) {
+	_deadline = deadline;
+	_hasDeadline = true;
+} // End PCD_SetDeadline()
+
+/**
+ * Lets PICC commands take their full timeout again.
+ */
+void MFRC522::PCD_ClearDeadline() {
+	_hasDeadline = false;
+} // End PCD_ClearDeadline()
+
+#if MFRC522_ENABLE_TRACE
+/**
+ * Starts recording every register access that goes to the bus into trace, or stops with nullptr.
+ * The trace must outlive the recording. See MFRC522Trace.h.
+ */
+void MFRC522::PCD_SetTrace(MFRC522Trace *trace	///< Ring buffer to record into, or nullptr
+						) {
+	_trace = trace;
+} // End PCD_SetTrace()
+#endif
+
+#if defined(ESP32)
+/**
+ * Interrupt handler for the IRQ pin. Wakes the task waiting in PCD_WaitForIrq().
+ */
+void IRAM_ATTR MFRC522::PCD_IrqHandler(void *arg	///< The MFRC522 instance given to attachInterruptArg().
+										) {
+	MFRC522 *self = static_cast<MFRC522 *>(arg);
+	BaseType_t woken = pdFALSE;
+	xSemaphoreGiveFromISR(self->_irqSemaphore, &woken);
+	portYIELD_FROM_ISR(woken);
+} // End PCD_IrqHandler()
+#endif
+
+/**
+ * Forgets interrupts left over from a previous command.
+ * Must be called before the command is started, so an early completion is not lost.
+ */
+void MFRC522::PCD_ClearIrq() {
+#if defined(ESP32)
+	xSemaphoreTake(_irqSemaphore, 0);
+#endif
+} // End PCD_ClearIrq()
+
+/**
+ * Sleeps until the IRQ pin fires or timeoutMs passed.
+ * The caller reads the IRQ registers afterwards to find out what happened.
+ * Without ESP32 there is no IRQ mode, so this is never called and returns right away.
+ */
+void MFRC522::PCD_WaitForIrq(uint32_t timeoutMs	///< Maximum time to wait in milliseconds.
+							) {
+#if defined(ESP32)
+	xSemaphoreTake(_irqSemaphore, pdMS_TO_TICKS(timeoutMs) + 1);	// +1 tick so a short timeout never rounds down to 0
+#else
+	(void)timeoutMs;
+#endif
+} // End PCD_WaitForIrq()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Power control
 /////////////////////////////////////////////////////////////////////////////////////
@@ -467,38 +968,85 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	byte txLastBits = validBits ? *validBits : 0;
 	byte bitFraming = (rxAlign << 4) + txLastBits;		// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 	
-	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
-	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
-	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
-	PCD_WriteRegister(FIFODataReg, sendLen, sendData);	// Write sendData to the FIFO
-	PCD_WriteRegister(BitFramingReg, bitFraming);		// Bit adjustments
-	PCD_WriteRegister(CommandReg, command);				// Execute the command
+	uint16_t timeout = PCD_GetTimeout(command, sendData, sendLen);
+	bool shortened = false;									// True if the deadline cut the timer short
+	if (_hasDeadline) {
+		int32_t remaining = (int32_t)(_deadline - millis());
+		if (remaining <= 0) {
+			_errors.deadlines++;
+			return STATUS_TIMEOUT;
+		}
+		if ((uint32_t)remaining * 40 < timeout) {			// The timer counts 40 ticks per ms
+			timeout = remaining * 40;
+			shortened = true;
+		}
+	}
+	
+	PCD_QueueRegisterWrite(CommandReg, PCD_Idle);			// Stop any active command.
+	PCD_QueueRegisterWrite(ComIrqReg, 0x7F);				// Clear all seven interrupt request bits
+	if (_irqPin != UNUSED_PIN) {
+		PCD_ClearIrq();
+		PCD_QueueRegisterWrite(ComIEnReg, 0x80 | waitIRq | 0x01);	// IRqInv=1 => IRQ pin is active low. Raise it on success or on TimerIRq.
+		PCD_QueueRegisterWrite(DivIEnReg, 0x80);				// IRQPushPull=1, CRCIEn=0
+	}
+	PCD_QueueRegisterWrite(TReloadRegH, timeout >> 8);		// Timeout for this command. Both are shadowed, so
+	PCD_QueueRegisterWrite(TReloadRegL, timeout & 0xFF);	// nothing is sent when it did not change.
+	PCD_QueueRegisterWrite(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
+	PCD_QueueRegisterWrite(FIFODataReg, sendLen, sendData);	// Write sendData to the FIFO
+	PCD_QueueRegisterWrite(BitFramingReg, bitFraming);		// Bit adjustments
+	PCD_QueueRegisterWrite(CommandReg, command);			// Execute the command
 	if (command == PCD_Transceive) {
-		PCD_SetRegisterBitMask(BitFramingReg, 0x80);	// StartSend=1, transmission of data starts
+		// StartSend=1, transmission of data starts. We just wrote bitFraming, so no read-modify-write is needed.
+		PCD_QueueRegisterWrite(BitFramingReg, bitFraming | 0x80);
 	}
+	PCD_FlushRegisterQueue();								// Send the whole setup in one bus transaction
 	
 	// Wait for the command to complete.
 	// In PCD_Init() we set the TAuto flag in TModeReg. This means the timer automatically starts when the PCD stops transmitting.
-	// Each iteration of the do-while-loop takes 17.86μs.
-	// TODO check/modify for other architectures than Arduino Uno 16bit
-	uint16_t i;
-	for (i = 2000; i > 0; i--) {
+	// The timer fires after at most TIMEOUT_DEFAULT (25ms), so 36ms without any of our interrupts means the MFRC522 itself is stuck.
+	// The bound is wall-clock time, because one ComIrqReg read takes anything from 17.86μs on an Arduino Uno
+	// to a few μs at 10MHz SPI. In IRQ mode the loop sleeps until the IRQ pin fires instead of reading ComIrqReg over and over.
+	// With a deadline set (PCD_SetDeadline()) both the timer and this wait end no later than the deadline.
+	const uint32_t start = millis();
+	for (;;) {
+		uint32_t elapsed = millis() - start;	// Taken before the read, so a task switch in between cannot cut the wait short
 		byte n = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
 		if (n & waitIRq) {					// One of the interrupts that signal success has been set.
 			break;
 		}
-		if (n & 0x01) {						// Timer interrupt - nothing received in 25ms
+		if (n & 0x01) {						// Timer interrupt - nothing received within the timeout
+			if (shortened) {
+				_errors.deadlines++;
+			}
+			else {
+				_errors.timeouts++;
+			}
 			return STATUS_TIMEOUT;
 		}
-	}
-	// 35.7ms and nothing happend. Communication with the MFRC522 might be down.
-	if (i == 0) {
-		return STATUS_TIMEOUT;
+		uint32_t waitLimit = 36;
+		if (_hasDeadline) {
+			int32_t remaining = (int32_t)(_deadline - millis());
+			if (remaining <= 0) {			// The timer starts only after sending, so it can end later than the deadline
+				_errors.deadlines++;
+				return STATUS_TIMEOUT;
+			}
+			if (elapsed + remaining < waitLimit) {
+				waitLimit = elapsed + remaining;
+			}
+		}
+		if (elapsed >= waitLimit) {		// 36ms and nothing happend. Communication with the MFRC522 might be down.
+			_errors.chipTimeouts++;
+			return STATUS_TIMEOUT;
+		}
+		if (_irqPin != UNUSED_PIN) {
+			PCD_WaitForIrq(waitLimit - elapsed);
+		}
 	}
 	
 	// Stop now if any errors except collisions were detected.
 	byte errorRegValue = PCD_ReadRegister(ErrorReg); // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
 	if (errorRegValue & 0x13) {	 // BufferOvfl ParityErr ProtocolErr
+		_errors.errors++;
 		return STATUS_ERROR;
 	}
   
@@ -520,6 +1068,7 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	
 	// Tell about collisions
 	if (errorRegValue & 0x08) {		// CollErr
+		_errors.collisions++;
 		return STATUS_COLLISION;
 	}
 	
@@ -527,10 +1076,12 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	if (backData && backLen && checkCRC) {
 		// In this case a MIFARE Classic NAK is not OK.
 		if (*backLen == 1 && _validBits == 4) {
+			_errors.nacks++;
 			return STATUS_MIFARE_NACK;
 		}
 		// We need at least the CRC_A value and all 8 bits of the last byte must be received.
 		if (*backLen < 2 || _validBits != 0) {
+			_errors.crcErrors++;
 			return STATUS_CRC_WRONG;
 		}
 		// Verify CRC_A - do our own calculation and store the control in controlBuffer.
@@ -540,6 +1091,7 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 			return status;
 		}
 		if ((backData[*backLen - 2] != controlBuffer[0]) || (backData[*backLen - 1] != controlBuffer[1])) {
+			_errors.crcErrors++;
 			return STATUS_CRC_WRONG;
 		}
 	}
@@ -547,6 +1099,42 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	return STATUS_OK;
 } // End PCD_CommunicateWithPICC()
 
+/**
+ * Returns the timer reload value for a command sent with PCD_CommunicateWithPICC().
+ * 
+ * Commands are recognised by their first byte and frame length, so data frames (the second step of a
+ * MIFARE write or value operation, T=CL blocks) are never mistaken for a short command.
+ * 
+ * @return One of the PCD_Timeout values.
+ */
+uint16_t MFRC522::PCD_GetTimeout(	byte command,			///< The command to execute. One of the PCD_Command enums.
+									const byte *sendData,	///< The data that will be transferred to the FIFO.
+									byte sendLen			///< Number of bytes in sendData.
+								) {
+	if (command != PCD_Transceive || sendData == nullptr || sendLen == 0) {
+		return TIMEOUT_DEFAULT;
+	}
+	switch (sendData[0]) {
+		case PICC_CMD_REQA:
+		case PICC_CMD_WUPA:
+			return (sendLen == 1) ? TIMEOUT_SHORT : TIMEOUT_DEFAULT;
+		case PICC_CMD_SEL_CL1:
+		case PICC_CMD_SEL_CL2:
+		case PICC_CMD_SEL_CL3:
+			return (sendLen >= 2 && sendLen <= 9) ? TIMEOUT_SHORT : TIMEOUT_DEFAULT;
+		case PICC_CMD_HLTA:
+			return (sendLen == 4 && sendData[1] == 0) ? TIMEOUT_SHORT : TIMEOUT_DEFAULT;
+		case PICC_CMD_MF_READ:
+			return (sendLen == 4) ? TIMEOUT_READ : TIMEOUT_DEFAULT;
+		case PICC_CMD_UL_FAST_READ:
+			return (sendLen == 5) ? TIMEOUT_READ : TIMEOUT_DEFAULT;
+		case PICC_CMD_UL_GET_VERSION:
+			return (sendLen == 3) ? TIMEOUT_READ : TIMEOUT_DEFAULT;
+		default:
+			return TIMEOUT_DEFAULT;
+	}
+} // End PCD_GetTimeout()
+
 /**
  * Transmits a REQuest command, Type A. Invites PICCs in state IDLE to go to READY and prepare for anticollision or selection. 7 bit frame.
  * Beware: When two PICCs are in the field at the same time I often get STATUS_TIMEOUT - probably due do bad antenna design.
@@ -861,6 +1449,74 @@ MFRC522::StatusCode MFRC522::PICC_HaltA() {
 	return result;
 } // End PICC_HaltA()
 
+/**
+ * Selects every PICC in the field, one after the other, and leaves each of them in state HALT.
+ * 
+ * Each pass selects one card through the anticollision loop in PICC_Select(), halts it so it no longer
+ * answers REQA, and sends REQA again to invite the remaining cards. It ends when no card answers.
+ * Remember to call PICC_IsNewCardPresent(), PICC_RequestA() or PICC_WakeupA() first.
+ * Use PICC_WakeupAndSelect() to talk to one of the returned cards afterwards.
+ * 
+ * @return The number of UIDs stored in uids.
+ */
+byte MFRC522::PICC_SelectAll(	Uid *uids,		///< Array to store the UIDs in
+								byte maxCount	///< Size of the uids array
+							) {
+	byte count = 0;
+	byte failures = 0;
+	
+	while (count < maxCount) {
+		if (PICC_Select(&uids[count]) == STATUS_OK) {
+			// A card that did not go to HALT would be found again on every pass
+			bool known = false;
+			for (byte i = 0; i < count && !known; i++) {
+				known = uids[i].size == uids[count].size && memcmp(uids[i].uidByte, uids[count].uidByte, uids[count].size) == 0;
+			}
+			PICC_HaltA();
+			if (known) {
+				break;
+			}
+			count++;
+		} else if (++failures >= 3) {
+			break;
+		}
+		
+		// Invite the cards that are still in state IDLE
+		byte bufferATQA[2];
+		byte bufferSize = sizeof(bufferATQA);
+		MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
+		if (result != STATUS_OK && result != STATUS_COLLISION) {
+			break;
+		}
+	}
+	return count;
+} // End PICC_SelectAll()
+
+/**
+ * Wakes all PICCs in the field, including halted ones, and selects the one with the given UID.
+ * On success the class variable uid is set to it.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_WakeupAndSelect(const Uid *target	///< UID of the PICC to select, as returned by PICC_SelectAll()
+												) {
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	MFRC522::StatusCode result = PICC_WakeupA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {	// Several cards answering is expected here
+		return result;
+	}
+	
+	// Selecting with the complete UID skips the anticollision loop and addresses just this card
+	Uid selected = *target;
+	result = PICC_Select(&selected, selected.size * 8);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	uid = selected;
+	return STATUS_OK;
+} // End PICC_WakeupAndSelect()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with MIFARE PICCs
 /////////////////////////////////////////////////////////////////////////////////////
@@ -1219,6 +1875,149 @@ MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Aut
 	return STATUS_OK;
 } // End PCD_NTAG216_AUTH()
 
+/**
+ * Reads the product information of a NTAG21x or MIFARE Ultralight EV1.
+ * 
+ * The 8 bytes returned are: vendor ID, product type, product subtype, major and minor version,
+ * storage size and protocol type. Use NTAG_GetUserMemorySize() to decode the storage size.
+ * Older tags (MIFARE Ultralight, NTAG203) answer with a NAK and fall back to IDLE,
+ * so the PICC must be selected again before talking to it after a failure.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_GetVersion(	byte *buffer,		///< The buffer to store the data in
+												byte *bufferSize	///< Buffer size, at least 10 bytes. Also number of bytes returned (including CRC_A) if STATUS_OK.
+											) {
+	MFRC522::StatusCode result;
+	
+	// Sanity check
+	if (buffer == nullptr || *bufferSize < 10) {
+		return STATUS_NO_ROOM;
+	}
+	
+	// Build command buffer
+	buffer[0] = PICC_CMD_UL_GET_VERSION;
+	// Calculate CRC_A
+	result = PCD_CalculateCRC(buffer, 1, &buffer[1]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	
+	// Transmit the buffer and receive the response, validate CRC_A.
+	return PCD_TransceiveData(buffer, 3, buffer, bufferSize, nullptr, 0, true);
+} // End NTAG_GetVersion()
+
+/**
+ * Reads the pages startPage to endPage (inclusive) of a NTAG21x or MIFARE Ultralight EV1 in one frame.
+ * 
+ * MIFARE_Read() returns 4 pages per command; FAST_READ returns up to FAST_READ_MAX_PAGES,
+ * which is as much as the FIFO can hold together with the CRC_A.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_FastRead(	byte startPage,		///< The first page to return data from.
+											byte endPage,		///< The last page to return data from.
+											byte *buffer,		///< The buffer to store the data in
+											byte *bufferSize	///< Buffer size, at least 4 bytes per page plus 2. Also number of bytes returned (including CRC_A) if STATUS_OK.
+										) {
+	MFRC522::StatusCode result;
+	
+	// Sanity check
+	if (endPage < startPage || endPage - startPage >= FAST_READ_MAX_PAGES) {
+		return STATUS_INVALID;
+	}
+	byte responseSize = (endPage - startPage + 1) * 4 + 2;
+	if (buffer == nullptr || *bufferSize < responseSize) {
+		return STATUS_NO_ROOM;
+	}
+	
+	// Build command buffer
+	buffer[0] = PICC_CMD_UL_FAST_READ;
+	buffer[1] = startPage;
+	buffer[2] = endPage;
+	// Calculate CRC_A
+	result = PCD_CalculateCRC(buffer, 3, &buffer[3]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	
+	// Transmit the buffer and receive the response, validate CRC_A.
+	result = PCD_TransceiveData(buffer, 5, buffer, bufferSize, nullptr, 0, true);
+	if (result == STATUS_OK && *bufferSize != responseSize) {
+		return STATUS_ERROR;
+	}
+	return result;
+} // End NTAG_FastRead()
+
+/**
+ * Reads the user memory of a NTAG21x or MIFARE Ultralight EV1, starting at page 4.
+ * 
+ * The size is taken from GET_VERSION and the data is read with as few FAST_READ frames as possible:
+ * 3 for a NTAG213 instead of the 9 MIFARE_Read commands needed to cover its 144 bytes.
+ * If the tag does not support GET_VERSION the error is returned and the PICC must be selected again
+ * before falling back to MIFARE_Read().
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_ReadUserMemory(	byte *buffer,			///< The buffer to store the data in
+													uint16_t *bufferSize	///< Buffer size. Also number of bytes returned if STATUS_OK; less than the user memory if the buffer is too small.
+												) {
+	MFRC522::StatusCode result;
+	byte frame[FAST_READ_MAX_PAGES * 4 + 2];
+	byte frameSize = sizeof(frame);
+	
+	// Sanity check
+	if (buffer == nullptr) {
+		return STATUS_NO_ROOM;
+	}
+	
+	result = NTAG_GetVersion(frame, &frameSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	uint16_t length = NTAG_GetUserMemorySize(frame);
+	if (length > *bufferSize) {
+		length = *bufferSize;
+	}
+	
+	uint16_t pages = (length + 3) / 4;
+	uint16_t done = 0;
+	for (uint16_t page = 0; page < pages; page += FAST_READ_MAX_PAGES) {
+		byte count = (pages - page > FAST_READ_MAX_PAGES) ? FAST_READ_MAX_PAGES : (pages - page);
+		frameSize = sizeof(frame);
+		result = NTAG_FastRead(4 + page, 4 + page + count - 1, frame, &frameSize);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		byte copy = (length - done > count * 4) ? count * 4 : (length - done);
+		memcpy(buffer + done, frame, copy);
+		done += copy;
+	}
+	
+	*bufferSize = done;
+	return STATUS_OK;
+} // End NTAG_ReadUserMemory()
+
+/**
+ * Decodes the storage size byte of a GET_VERSION response into the number of user memory bytes.
+ * 
+ * Known NXP products return their exact size. For other tags the storage size byte only gives a range,
+ * and the lower end of it is returned.
+ * 
+ * @return The user memory size in bytes.
+ */
+uint16_t MFRC522::NTAG_GetUserMemorySize(const byte *version	///< The 8 bytes returned by NTAG_GetVersion().
+										) {
+	switch (version[6]) {
+		case 0x0B:	return 48;		// MIFARE Ultralight EV1 MF0UL11
+		case 0x0E:	return 128;		// MIFARE Ultralight EV1 MF0UL21
+		case 0x0F:	return 144;		// NTAG213
+		case 0x11:	return 504;		// NTAG215
+		case 0x13:	return 888;		// NTAG216
+		default:	return (version[6] >> 1) < 16 ? 1 << (version[6] >> 1) : 0;
+	}
+} // End NTAG_GetUserMemorySize()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Support functions
@@ -1266,6 +2065,7 @@ MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(	byte *sendData,		///< Pointe
 		return STATUS_ERROR;
 	}
 	if (cmdBuffer[0] != MF_ACK) {
+		_errors.nacks++;
 		return STATUS_MIFARE_NACK;
 	}
 	return STATUS_OK;
@@ -1342,6 +2142,7 @@ const __FlashStringHelper *MFRC522::PICC_GetTypeName(PICC_Type piccType	///< One
 	}
 } // End PICC_GetTypeName()
 
+#if MFRC522_ENABLE_DUMP
 /**
  * Dumps debug info about the connected PCD to Serial.
  * Shows all known firmware versions
@@ -1671,6 +2472,7 @@ void MFRC522::PICC_DumpMifareUltralightToSerial() {
 		}
 	}
 } // End PICC_DumpMifareUltralightToSerial()
+#endif // MFRC522_ENABLE_DUMP
 
 /**
  * Calculates the bit pattern needed for the specified access bits. In the [C1 C2 C3] tuples C1 is MSB (=4) and C3 is LSB (=1).
@@ -1690,6 +2492,7 @@ void MFRC522::MIFARE_SetAccessBits(	byte *accessBitBuffer,	///< Pointer to byte
 	accessBitBuffer[2] =          c3 << 4 | c2;
 } // End MIFARE_SetAccessBits()
 
+#if MFRC522_ENABLE_UID_BACKDOOR
 
 /**
  * Performs the "magic sequence" needed to get Chinese UID changeable
@@ -1890,6 +2693,7 @@ bool MFRC522::MIFARE_UnbrickUidSector(bool logErrors) {
 	}
 	return true;
 }
+#endif // MFRC522_ENABLE_UID_BACKDOOR
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Convenience functions - does not add extra functionality
@@ -17,9 +17,35 @@
 #include <stdint.h>
 #include <Arduino.h>
 #include <SPI.h>
+#include "MFRC522Transport.h"
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
 
 #ifndef MFRC522_SPICLOCK
-#define MFRC522_SPICLOCK (4000000u)	// MFRC522 accept upto 10MHz, set to 4MHz.
+#define MFRC522_SPICLOCK (4000000u)	// MFRC522 accept upto 10MHz, set to 4MHz. Default only, see PCD_SetSPIClock().
+#endif
+
+// Where CRC_A is calculated. 1 = table driven in software on the host CPU,
+// 0 = in the CRC coprocessor of the MFRC522 (several SPI round trips per frame).
+#ifndef MFRC522_SOFTWARE_CRC
+#define MFRC522_SOFTWARE_CRC (1)
+#endif
+
+// Optional parts of the library. Set to 0 to leave them out of builds that link without section garbage
+// collection, or to make sure nothing in the firmware can rewrite block 0 of a card.
+#ifndef MFRC522_ENABLE_DUMP
+#define MFRC522_ENABLE_DUMP (1)			// PCD_DumpVersionToSerial() and the PICC_Dump...ToSerial() functions
+#endif
+#ifndef MFRC522_ENABLE_UID_BACKDOOR
+#define MFRC522_ENABLE_UID_BACKDOOR (1)	// MIFARE_OpenUidBackdoor(), MIFARE_SetUid() and MIFARE_UnbrickUidSector()
+#endif
+#ifndef MFRC522_ENABLE_TRACE
+#define MFRC522_ENABLE_TRACE (0)			// PCD_SetTrace(): records register accesses, see MFRC522Trace.h
+#endif
+#if MFRC522_ENABLE_TRACE
+#include "MFRC522Trace.h"
 #endif
 
 // Firmware data for self-test
@@ -81,6 +107,10 @@ public:
 	static constexpr byte FIFO_SIZE = 64;		// The FIFO is 64 bytes.
 	// Default value for unused pin
 	static constexpr uint8_t UNUSED_PIN = UINT8_MAX;
+	// Size of the register write queue, enough for a full FIFO load plus the command setup around it
+	static constexpr byte REG_QUEUE_SIZE = FIFO_SIZE + 32;
+	// Pages per FAST_READ frame. The response and its CRC_A must fit in the FIFO.
+	static constexpr byte FAST_READ_MAX_PAGES = (FIFO_SIZE - 2) / 4;
 
 	// MFRC522 registers. Described in chapter 9 of the datasheet.
 	// When using SPI all addresses are shifted one bit left in the "SPI address byte" (section 8.1.2.3)
@@ -212,7 +242,10 @@ public:
 		PICC_CMD_MF_TRANSFER	= 0xB0,		// Writes the contents of the internal data register to a block.
 		// The commands used for MIFARE Ultralight (from http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
 		// The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE Ultralight.
-		PICC_CMD_UL_WRITE		= 0xA2		// Writes one 4 byte page to the PICC.
+		PICC_CMD_UL_WRITE		= 0xA2,		// Writes one 4 byte page to the PICC.
+		// The commands used for NTAG21x and MIFARE Ultralight EV1 (from https://www.nxp.com/docs/en/data-sheet/NTAG213_215_216.pdf, Section 10)
+		PICC_CMD_UL_GET_VERSION	= 0x60,		// Returns 8 bytes of product information, including the memory size. Same code as PICC_CMD_MF_AUTH_KEY_A.
+		PICC_CMD_UL_FAST_READ	= 0x3A		// Reads a range of pages in one frame.
 	};
 	
 	// MIFARE constants that does not fit anywhere else
@@ -221,6 +254,14 @@ public:
 		MF_KEY_SIZE				= 6			// A Mifare Crypto1 key is 6 bytes.
 	};
 	
+	// Timer reload values in 25μs ticks (TPrescaler 0xA9 => 40kHz), chosen per command by PCD_CommunicateWithPICC().
+	// With TAuto the timer only runs from the end of our frame until the PICC starts answering.
+	enum PCD_Timeout : uint16_t {
+		TIMEOUT_SHORT			= 40,		// 1ms. REQA, WUPA, anticollision, SELECT and HLTA are answered within about 90μs (ISO 14443-3 FDT).
+		TIMEOUT_READ			= 200,		// 5ms. READ, FAST_READ and GET_VERSION.
+		TIMEOUT_DEFAULT			= 1000		// 25ms. Authentication, writes, value operations, T=CL and anything not recognised.
+	};
+	
 	// PICC types we can detect. Remember to update PICC_GetTypeName() if you add more.
 	// last value set to 0xff, then compiler uses less ram, it seems some optimisations are triggered
 	enum PICC_Type : byte {
@@ -263,6 +304,18 @@ public:
 		byte		keyByte[MF_KEY_SIZE];
 	} MIFARE_Key;
 	
+	// Error counters kept by PCD_CommunicateWithPICC() and PCD_MIFARE_Transceive(). See PCD_GetErrorCounters().
+	typedef struct {
+		uint32_t	timeouts;		// No answer from the PICC before the timer expired. Every poll without a card counts here.
+		uint32_t	chipTimeouts;	// The MFRC522 itself did not finish the command. Points at the chip or the wiring.
+		uint32_t	crcErrors;		// CRC_A of a response did not match
+		uint32_t	collisions;		// Bit collision, more than one PICC answered
+		uint32_t	nacks;			// A MIFARE PICC answered with NAK
+		uint32_t	errors;			// BufferOvfl, ParityErr or ProtocolErr
+		uint32_t	recoveries;		// Resets done by PCD_Recover()
+		uint32_t	deadlines;		// Commands not started or cut short because the PCD_SetDeadline() time was up
+	} PCD_ErrorCounters;
+	
 	// Member variables
 	Uid uid;								// Used by PICC_ReadCardSerial().
 	
@@ -272,6 +325,7 @@ public:
 	MFRC522();
 	MFRC522(byte resetPowerDownPin);
 	MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+	MFRC522(MFRC522Transport &transport, byte resetPowerDownPin = UNUSED_PIN);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Basic interface functions for communicating with the MFRC522
@@ -282,7 +336,13 @@ public:
 	void PCD_ReadRegister(PCD_Register reg, byte count, byte *values, byte rxAlign = 0);
 	void PCD_SetRegisterBitMask(PCD_Register reg, byte mask);
 	void PCD_ClearRegisterBitMask(PCD_Register reg, byte mask);
+	void PCD_QueueRegisterWrite(PCD_Register reg, byte value);
+	void PCD_QueueRegisterWrite(PCD_Register reg, byte count, byte *values);
+	void PCD_FlushRegisterQueue();
+	void PCD_InvalidateShadow();
+	uint32_t PCD_GetShadowHitCount();
 	StatusCode PCD_CalculateCRC(byte *data, byte length, byte *result);
+	static void CalculateCRC_A(const byte *data, byte length, byte *result);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for manipulating the MFRC522
@@ -296,6 +356,21 @@ public:
 	byte PCD_GetAntennaGain();
 	void PCD_SetAntennaGain(byte mask);
 	bool PCD_PerformSelfTest();
+	bool PCD_PerformFIFOLoopbackTest();
+	void PCD_SetSPIClock(uint32_t clock);
+	uint32_t PCD_GetSPIClock();
+	uint32_t PCD_CalibrateSPIClock(uint32_t maxClock = 10000000u);
+	void PCD_EnableIrq(byte irqPin);
+	void PCD_DisableIrq();
+	bool PCD_CheckHealth(bool selfTest = false);
+	void PCD_Recover();
+	const PCD_ErrorCounters &PCD_GetErrorCounters() const;
+	void PCD_ResetErrorCounters();
+	void PCD_SetDeadline(uint32_t deadline);
+	void PCD_ClearDeadline();
+#if MFRC522_ENABLE_TRACE
+	void PCD_SetTrace(MFRC522Trace *trace);
+#endif
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Power control functions
@@ -313,6 +388,8 @@ public:
 	StatusCode PICC_REQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize);
 	virtual StatusCode PICC_Select(Uid *uid, byte validBits = 0);
 	StatusCode PICC_HaltA();
+	byte PICC_SelectAll(Uid *uids, byte maxCount);
+	StatusCode PICC_WakeupAndSelect(const Uid *target);
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with MIFARE PICCs
@@ -329,6 +406,10 @@ public:
 	StatusCode MIFARE_GetValue(byte blockAddr, int32_t *value);
 	StatusCode MIFARE_SetValue(byte blockAddr, int32_t value);
 	StatusCode PCD_NTAG216_AUTH(byte *passWord, byte pACK[]);
+	StatusCode NTAG_GetVersion(byte *buffer, byte *bufferSize);
+	StatusCode NTAG_FastRead(byte startPage, byte endPage, byte *buffer, byte *bufferSize);
+	StatusCode NTAG_ReadUserMemory(byte *buffer, uint16_t *bufferSize);
+	static uint16_t NTAG_GetUserMemorySize(const byte *version);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
@@ -342,6 +423,7 @@ public:
 	//const char *PICC_GetTypeName(byte type);
 	static const __FlashStringHelper *PICC_GetTypeName(PICC_Type type);
 	
+#if MFRC522_ENABLE_DUMP
 	// Support functions for debuging
 	void PCD_DumpVersionToSerial();
 	void PICC_DumpToSerial(Uid *uid);
@@ -349,12 +431,15 @@ public:
 	void PICC_DumpMifareClassicToSerial(Uid *uid, PICC_Type piccType, MIFARE_Key *key);
 	void PICC_DumpMifareClassicSectorToSerial(Uid *uid, MIFARE_Key *key, byte sector);
 	void PICC_DumpMifareUltralightToSerial();
+#endif
 	
 	// Advanced functions for MIFARE
 	void MIFARE_SetAccessBits(byte *accessBitBuffer, byte g0, byte g1, byte g2, byte g3);
+#if MFRC522_ENABLE_UID_BACKDOOR
 	bool MIFARE_OpenUidBackdoor(bool logErrors);
 	bool MIFARE_SetUid(byte *newUid, byte uidSize, bool logErrors);
 	bool MIFARE_UnbrickUidSector(bool logErrors);
+#endif
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Convenience functions - does not add extra functionality
@@ -363,8 +448,31 @@ public:
 	virtual bool PICC_ReadCardSerial();
 	
 protected:
-	byte _chipSelectPin;		// Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+	MFRC522TransportSPI _spiTransport;	// Used unless a transport is passed to the constructor
+	MFRC522Transport *_transport;	// Bus the MFRC522 is on, see MFRC522Transport.h
 	byte _resetPowerDownPin;	// Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
+	uint32_t _spiClock;			// Bus clock in Hz, MFRC522_SPICLOCK unless changed with PCD_SetSPIClock()
+	byte _regQueue[REG_QUEUE_SIZE];	// Pending register writes, stored as [frame length][address][data...]. See PCD_QueueRegisterWrite().
+	byte _regQueueLength;		// Number of bytes used in _regQueue
+	byte _shadow[64];			// Last value written to or read from each configuration register, indexed by address (reg >> 1)
+	uint64_t _shadowValid;		// Bit n set => _shadow[n] holds the current value of register n
+	uint32_t _shadowHits;		// Number of SPI transactions saved by the shadow, see PCD_GetShadowHitCount()
+	PCD_ErrorCounters _errors;	// See PCD_GetErrorCounters()
+	bool _hasDeadline;			// True while PCD_SetDeadline() limits PCD_CommunicateWithPICC()
+	uint32_t _deadline;			// millis() value no command may run past
+#if MFRC522_ENABLE_TRACE
+	MFRC522Trace *_trace;		// nullptr unless tracing, see PCD_SetTrace()
+#endif
+	static bool PCD_IsShadowed(PCD_Register reg);
+	bool PCD_ShadowWrite(PCD_Register reg, byte value);
+	static uint16_t PCD_GetTimeout(byte command, const byte *sendData, byte sendLen);
+	byte _irqPin;				// Arduino pin connected to MFRC522's interrupt request output (Pin 23, IRQ), or UNUSED_PIN to poll over SPI. Only ESP32 has IRQ mode.
+#if defined(ESP32)
+	SemaphoreHandle_t _irqSemaphore;	// Given from the GPIO interrupt, taken by the task waiting in PCD_WaitForIrq()
+	static void PCD_IrqHandler(void *arg);
+#endif
+	void PCD_ClearIrq();
+	void PCD_WaitForIrq(uint32_t timeoutMs);
 	StatusCode MIFARE_TwoStepHelper(byte command, byte blockAddr, int32_t data);
 };
 
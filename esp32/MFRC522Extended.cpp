@@ -239,98 +239,11 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 	// A Request ATS command should be sent
 	// We also check SAK bit 3 is cero, as it stands for UID complete (1 would tell us it is incomplete)
 	if ((uid->sak & 0x24) == 0x20) {
-		Ats ats;
-		result = PICC_RequestATS(&ats);
-		if (result == STATUS_OK) {
-			// Check the ATS
-			if (ats.size > 0)
-			{
-				// TA1 has been transmitted?
-				// PPS must be supported...
-				if (ats.ta1.transmitted)
-				{
-					// TA1
-					//  8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | Description
-					// ---+---+---+---+---+---+---+---+------------------------------------------
-					//  0 | - | - | - | 0 | - | - | - | Different D for each direction supported
-					//  1 | - | - | - | 0 | - | - | - | Only same D for both direction supported
-					//  - | x | x | x | 0 | - | - | - | DS (Send D)
-					//  - | - | - | - | 0 | x | x | x | DR (Receive D)
-					//
-					// D to bitrate table
-					//  3 | 2 | 1 | Value
-					// ---+---+---+-----------------------------
-					//  1 | - | - | 848 kBaud is supported
-					//  - | 1 | - | 424 kBaud is supported
-					//  - | - | 1 | 212 kBaud is supported
-					//  0 | 0 | 0 | Only 106 kBaud is supported
-					//
-					// Note: 106 kBaud is always supported
-					//
-					// I have almost constant timeouts when changing speeds :(
-					// default never used, so only delarate
-					//TagBitRates ds = BITRATE_106KBITS; 
-					//TagBitRates dr = BITRATE_106KBITS;
-					TagBitRates ds;
-					TagBitRates dr;
-					
-					//// TODO Not working at 848 or 424
-					//if (ats.ta1.ds & 0x04) 
-					//{
-					//	ds = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.ds & 0x02)
-					//{
-					//	ds = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.ds & 0x01)
-					//{
-					//	ds = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	ds = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.ds & 0x01)
-					{
-						ds = BITRATE_212KBITS;
-					}
-					else 
-					{
-						ds = BITRATE_106KBITS;
-					}
-
-					//// Not working at 848 or 424
-					//if (ats.ta1.dr & 0x04) 
-					//{
-					//	dr = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.dr & 0x02)
-					//{
-					//	dr = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.dr & 0x01)
-					//{
-					//	dr = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	dr = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.dr & 0x01)
-					{
-						dr = BITRATE_212KBITS;
-					}
-					else
-					{
-						dr = BITRATE_106KBITS;
-					}
-
-					PICC_PPS(ds, dr);
-				}
-			}
+		result = PICC_RequestATS(&tag.ats);
+		tag.blockNumber = false;	// A new ISO/IEC 14443-4 session starts with block number 0
+		if (result == STATUS_OK && tag.ats.size > 0) {
+			// Switch to the fastest bit rate both sides support
+			PICC_NegotiateBitRate(&tag.ats);
 		}
 	}
 
@@ -616,8 +529,8 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 			PCD_WriteRegister(TxModeReg, txReg);
 			PCD_WriteRegister(RxModeReg, rxReg);
 
-			// At 212kBps
-			switch (sendBitRate) {
+			// The modulation width follows the PCD to PICC bit rate (DR)
+			switch (receiveBitRate) {
 				case BITRATE_212KBITS:
 					{
 						//PCD_WriteRegister(ModWidthReg, 0x13);
@@ -655,6 +568,73 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 	return result;
 } // End PICC_PPS()
 
+/**
+ * Selects the fastest bit rates allowed by TA(1) of the ATS and PCD_SetMaxBitRate(), and sends a PPS for them.
+ * Nothing is sent if the card only supports 106 kBit/s.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::PICC_NegotiateBitRate(Ats *ats)
+{
+	// TA1
+	//  8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | Description
+	// ---+---+---+---+---+---+---+---+------------------------------------------
+	//  0 | - | - | - | 0 | - | - | - | Different D for each direction supported
+	//  1 | - | - | - | 0 | - | - | - | Only same D for both direction supported
+	//  - | x | x | x | 0 | - | - | - | DS (Send D)
+	//  - | - | - | - | 0 | x | x | x | DR (Receive D)
+	//
+	// D to bitrate table
+	//  3 | 2 | 1 | Value
+	// ---+---+---+-----------------------------
+	//  1 | - | - | 848 kBaud is supported
+	//  - | 1 | - | 424 kBaud is supported
+	//  - | - | 1 | 212 kBaud is supported
+	//  0 | 0 | 0 | Only 106 kBaud is supported
+	//
+	// Note: 106 kBaud is always supported
+	if (!ats->ta1.transmitted) {
+		return STATUS_OK;
+	}
+
+	TagBitRates ds = PICC_HighestBitRate(ats->ta1.ds, _maxBitRate);
+	TagBitRates dr = PICC_HighestBitRate(ats->ta1.dr, _maxBitRate);
+	if (ats->ta1.sameD) {
+		ds = dr = (ds < dr) ? ds : dr;
+	}
+
+	if (ds == BITRATE_106KBITS && dr == BITRATE_106KBITS) {
+		return STATUS_OK;
+	}
+
+	return PICC_PPS(ds, dr);
+} // End PICC_NegotiateBitRate()
+
+/**
+ * Sets the highest bit rate PICC_NegotiateBitRate() may select. Defaults to MFRC522_MAX_BITRATE.
+ */
+void MFRC522Extended::PCD_SetMaxBitRate(TagBitRates maxBitRate	///< BITRATE_106KBITS disables the negotiation
+										) {
+	_maxBitRate = maxBitRate;
+} // End PCD_SetMaxBitRate()
+
+/**
+ * Returns the highest bit rate in a TA(1) DS or DR bit mask that does not exceed maxBitRate.
+ */
+MFRC522Extended::TagBitRates MFRC522Extended::PICC_HighestBitRate(byte supported, TagBitRates maxBitRate)
+{
+	if ((supported & 0x04) && maxBitRate >= BITRATE_848KBITS) {
+		return BITRATE_848KBITS;
+	}
+	if ((supported & 0x02) && maxBitRate >= BITRATE_424KBITS) {
+		return BITRATE_424KBITS;
+	}
+	if ((supported & 0x01) && maxBitRate >= BITRATE_212KBITS) {
+		return BITRATE_212KBITS;
+	}
+	return BITRATE_106KBITS;
+} // End PICC_HighestBitRate()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with ISO/IEC 14433-4 cards
@@ -726,9 +706,7 @@ MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *ba
 	// Check if CRC is taken care of by MFRC522
 	byte rxModeReg = PCD_ReadRegister(TxModeReg);
 	if ((rxModeReg & 0x80) != 0x80) {
-		Serial.print("CRC is not taken care of by MFRC522: ");
-		Serial.println(rxModeReg, HEX);
-
+		// Only 106 kBit/s, PICC_PPS() never ran: check the CRC here
 		// Check the CRC
 		// We need at least the CRC_A value.
 		if ((int)(inBufferSize - inBufferOffset) < 2) {
@@ -835,21 +813,29 @@ MFRC522::StatusCode MFRC522Extended::TCL_Transceive(TagInfo *tag, byte *sendData
 
 	// Result is chained
 	// Send an ACK to receive more data
-	// TODO: Should be checked I've never needed to send an ACK
 	while (in.prologue.pcb & 0x10) {
-		byte ackData[FIFO_SIZE];
-		byte ackDataSize = FIFO_SIZE;
-
-		result = TCL_TransceiveRBlock(tag, true, ackData, &ackDataSize);
+		PcbBlock ack;
+		ack.prologue.pcb = 0xA2 | (out.prologue.pcb & 0x08) | (tag->blockNumber ? 0x01 : 0x00);
+		ack.prologue.cid = 0x00;
+		ack.prologue.nad = 0x00;
+		ack.inf.size = 0;
+		ack.inf.data = NULL;
+
+		in.inf.data = outBuffer;
+		in.inf.size = outBufferSize;
+		result = TCL_Transceive(&ack, &in);
 		if (result != STATUS_OK)
 			return result;
 
+		// Swap block number on success
+		tag->blockNumber = !tag->blockNumber;
+
 		if (backData && backLen && (*backLen > 0)) {
-			if ((*backLen + ackDataSize) > totalBackLen)
+			if ((*backLen + in.inf.size) > totalBackLen)
 				return STATUS_NO_ROOM;
 
-			memcpy(&(backData[*backLen]), ackData, ackDataSize);
-			*backLen += ackDataSize;
+			memcpy(&(backData[*backLen]), in.inf.data, in.inf.size);
+			*backLen += in.inf.size;
 		}
 	}
 	
@@ -946,6 +932,145 @@ MFRC522::StatusCode MFRC522Extended::TCL_Deselect(TagInfo *tag)
 	return result;
 } // End TCL_Deselect()
 
+/**
+ * Sends a command APDU in an I-Block and checks the status word of the response.
+ * The status word is removed from backData.
+ *
+ * @return STATUS_OK if the card answered 90 00, STATUS_ERROR for any other status word, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveAPDU(TagInfo *tag,		///< The selected ISO/IEC 14443-4 PICC
+														byte *apdu,			///< The command APDU
+														byte apduLen,		///< Number of bytes in apdu
+														byte *backData,		///< The buffer to store the response data in
+														byte *backLen		///< Buffer size. Also number of data bytes returned if STATUS_OK.
+													) {
+	MFRC522::StatusCode result;
+	byte response[FIFO_SIZE];
+	byte responseSize = FIFO_SIZE;
+
+	result = TCL_Transceive(tag, apdu, apduLen, response, &responseSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Status word SW1 SW2
+	if (responseSize < 2 || response[responseSize - 2] != 0x90 || response[responseSize - 1] != 0x00) {
+		return STATUS_ERROR;
+	}
+	responseSize -= 2;
+
+	if (backData && backLen) {
+		if (*backLen < responseSize) {
+			return STATUS_NO_ROOM;
+		}
+		memcpy(backData, response, responseSize);
+		*backLen = responseSize;
+	}
+	return STATUS_OK;
+} // End TCL_TransceiveAPDU()
+
+/**
+ * Reads the NDEF message of a NFC Forum Type 4 Tag (DESFire EV1 and later, NTAG 424 DNA, ...).
+ *
+ * Selects the NDEF application and the capability container, then reads the NDEF file with
+ * READ BINARY commands as large as both the frame size and the card's MLe allow.
+ * The PICC must have been selected with PICC_ReadCardSerial(), which also negotiates the bit rate.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_ReadNdef(	TagInfo *tag,		///< The selected ISO/IEC 14443-4 PICC
+													byte *buffer,		///< The buffer to store the NDEF message in, without the NLEN field
+													uint16_t *bufferSize	///< Buffer size. Also number of bytes returned if STATUS_OK.
+												) {
+	MFRC522::StatusCode result;
+	byte data[FIFO_SIZE];
+	byte dataSize;
+
+	if (buffer == NULL || bufferSize == NULL) {
+		return STATUS_INVALID;
+	}
+
+	// SELECT the NDEF Tag Application by name
+	byte selectApp[] = { 0x00, 0xA4, 0x04, 0x00, 0x07, 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00 };
+	dataSize = sizeof(data);
+	result = TCL_TransceiveAPDU(tag, selectApp, sizeof(selectApp), data, &dataSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// SELECT and read the capability container (file E103)
+	byte selectCC[] = { 0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE1, 0x03 };
+	dataSize = sizeof(data);
+	result = TCL_TransceiveAPDU(tag, selectCC, sizeof(selectCC), data, &dataSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	byte readCC[] = { 0x00, 0xB0, 0x00, 0x00, 0x0F };
+	dataSize = sizeof(data);
+	result = TCL_TransceiveAPDU(tag, readCC, sizeof(readCC), data, &dataSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// CCLEN(2) | Mapping version(1) | MLe(2) | MLc(2) | NDEF File Control TLV: T=04 L=06 File ID(2) Max size(2) Read(1) Write(1)
+	if (dataSize < 15 || data[7] != 0x04 || data[13] != 0x00) {
+		return STATUS_ERROR;	// No NDEF file or no free read access
+	}
+	uint16_t mle = ((uint16_t)data[3] << 8) | data[4];
+	byte fileId[2] = { data[9], data[10] };
+
+	// Largest READ BINARY the frame allows: FSD minus PCB, CID, status word and CRC_A
+	byte maxLe = FIFO_SIZE - 6;
+	if (mle > 0 && mle < maxLe) {
+		maxLe = mle;
+	}
+
+	// SELECT the NDEF file
+	byte selectNdef[] = { 0x00, 0xA4, 0x00, 0x0C, 0x02, fileId[0], fileId[1] };
+	dataSize = sizeof(data);
+	result = TCL_TransceiveAPDU(tag, selectNdef, sizeof(selectNdef), data, &dataSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// NLEN, the length of the NDEF message
+	byte readLength[] = { 0x00, 0xB0, 0x00, 0x00, 0x02 };
+	dataSize = sizeof(data);
+	result = TCL_TransceiveAPDU(tag, readLength, sizeof(readLength), data, &dataSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (dataSize != 2) {
+		return STATUS_ERROR;
+	}
+	uint16_t length = ((uint16_t)data[0] << 8) | data[1];
+	if (length > *bufferSize) {
+		return STATUS_NO_ROOM;
+	}
+
+	// The message itself, starting after NLEN
+	uint16_t done = 0;
+	while (done < length) {
+		uint16_t offset = done + 2;
+		byte le = (length - done > maxLe) ? maxLe : (length - done);
+		byte readBinary[] = { 0x00, 0xB0, (byte)(offset >> 8), (byte)(offset & 0xFF), le };
+		dataSize = sizeof(data);
+		result = TCL_TransceiveAPDU(tag, readBinary, sizeof(readBinary), data, &dataSize);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if (dataSize == 0 || dataSize > le) {
+			return STATUS_ERROR;
+		}
+		memcpy(buffer + done, data, dataSize);
+		done += dataSize;
+	}
+
+	*bufferSize = length;
+	return STATUS_OK;
+} // End TCL_ReadNdef()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Support functions
 /////////////////////////////////////////////////////////////////////////////////////
@@ -980,6 +1105,7 @@ MFRC522::PICC_Type MFRC522Extended::PICC_GetType(TagInfo *tag		///< The TagInfo
 	}
 } // End PICC_GetType()
 
+#if MFRC522_ENABLE_DUMP
 /**
  * Dumps debug info about the selected PICC to Serial.
  * On success the PICC is halted after dumping the data.
@@ -1088,6 +1214,7 @@ void MFRC522Extended::PICC_DumpISO14443_4(TagInfo *tag)
 	}
 	
 } // End PICC_DumpISO14443_4
+#endif // MFRC522_ENABLE_DUMP
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Convenience functions - does not add extra functionality
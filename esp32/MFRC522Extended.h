@@ -9,6 +9,10 @@
 #include <Arduino.h>
 #include "MFRC522.h"
 
+#ifndef MFRC522_MAX_BITRATE
+#define MFRC522_MAX_BITRATE BITRATE_848KBITS	// Highest ISO/IEC 14443-4 bit rate negotiated after RATS. Default only, see PCD_SetMaxBitRate().
+#endif
+
 class MFRC522Extended : public MFRC522 {
 		
 public:
@@ -77,9 +81,10 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Contructors
 	/////////////////////////////////////////////////////////////////////////////////////
-	MFRC522Extended() : MFRC522() {};
-	MFRC522Extended(uint8_t rst) : MFRC522(rst) {};
-	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst) {};
+	MFRC522Extended() : MFRC522(), _maxBitRate(MFRC522_MAX_BITRATE) {};
+	MFRC522Extended(uint8_t rst) : MFRC522(rst), _maxBitRate(MFRC522_MAX_BITRATE) {};
+	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst), _maxBitRate(MFRC522_MAX_BITRATE) {};
+	MFRC522Extended(MFRC522Transport &transport, uint8_t rst = UNUSED_PIN) : MFRC522(transport, rst), _maxBitRate(MFRC522_MAX_BITRATE) {};
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with PICCs
@@ -88,6 +93,8 @@ public:
 	StatusCode PICC_RequestATS(Ats *ats);
 	StatusCode PICC_PPS();	                                                  // PPS command without bitrate parameter
 	StatusCode PICC_PPS(TagBitRates sendBitRate, TagBitRates receiveBitRate); // Different D values
+	StatusCode PICC_NegotiateBitRate(Ats *ats);                               // PPS for the fastest rate TA1 allows
+	void PCD_SetMaxBitRate(TagBitRates maxBitRate);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with ISO/IEC 14433-4 cards
@@ -96,6 +103,8 @@ public:
 	StatusCode TCL_Transceive(TagInfo * tag, byte *sendData, byte sendLen, byte *backData = NULL, byte *backLen = NULL);
 	StatusCode TCL_TransceiveRBlock(TagInfo *tag, bool ack, byte *backData = NULL, byte *backLen = NULL);
 	StatusCode TCL_Deselect(TagInfo *tag);
+	StatusCode TCL_TransceiveAPDU(TagInfo *tag, byte *apdu, byte apduLen, byte *backData, byte *backLen);
+	StatusCode TCL_ReadNdef(TagInfo *tag, byte *buffer, uint16_t *bufferSize); // NFC Forum Type 4 Tag
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
@@ -103,18 +112,24 @@ public:
 	static PICC_Type PICC_GetType(TagInfo *tag);
 	using MFRC522::PICC_GetType;// // make old PICC_GetType(byte sak) available, otherwise would be hidden by PICC_GetType(TagInfo *tag)
 
+#if MFRC522_ENABLE_DUMP
 	// Support functions for debuging
 	void PICC_DumpToSerial(TagInfo *tag);
 	using MFRC522::PICC_DumpToSerial; // make old PICC_DumpToSerial(Uid *uid) available, otherwise would be hidden by PICC_DumpToSerial(TagInfo *tag)
 	void PICC_DumpDetailsToSerial(TagInfo *tag);
 	using MFRC522::PICC_DumpDetailsToSerial; // make old PICC_DumpDetailsToSerial(Uid *uid) available, otherwise would be hidden by PICC_DumpDetailsToSerial(TagInfo *tag)
 	void PICC_DumpISO14443_4(TagInfo *tag);
+#endif
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Convenience functions - does not add extra functionality
 	/////////////////////////////////////////////////////////////////////////////////////
 	bool PICC_IsNewCardPresent() override; // overrride
 	bool PICC_ReadCardSerial() override; // overrride
+
+protected:
+	TagBitRates _maxBitRate;	// Highest bit rate PICC_NegotiateBitRate() selects
+	static TagBitRates PICC_HighestBitRate(byte supported, TagBitRates maxBitRate);
 };
 
 #endif
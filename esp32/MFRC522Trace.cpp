@@ -0,0 +1,79 @@
+/*
+ * MFRC522Trace.cpp - Ring buffer of MFRC522 register operations. See MFRC522Trace.h.
+ */
+#include "MFRC522Trace.h"
+
+/**
+ * Constructor.
+ */
+MFRC522Trace::MFRC522Trace() {
+	Clear();
+} // End constructor
+
+/**
+ * Records one register access. Called by MFRC522 for every access that goes to the bus.
+ */
+void MFRC522Trace::Record(	uint32_t micros,		///< micros() when the access started
+							uint8_t reg,			///< One of the PCD_Register enums
+							bool read,				///< true for reads
+							uint8_t count,			///< Number of bytes transferred
+							const uint8_t *values	///< The bytes written or read. Only the first one is kept.
+						) {
+	Entry &entry = _entries[_next];
+	entry.micros = micros;
+	entry.address = reg >> 1;
+	entry.count = count;
+	entry.value = count ? values[0] : 0;
+	entry.read = read;
+	_next = (_next + 1) % MFRC522_TRACE_SIZE;
+	_total++;
+} // End Record()
+
+/**
+ * Drops all entries.
+ */
+void MFRC522Trace::Clear() {
+	_next = 0;
+	_total = 0;
+} // End Clear()
+
+/**
+ * Returns the number of entries in the buffer.
+ */
+uint16_t MFRC522Trace::Count() const {
+	return (_total < MFRC522_TRACE_SIZE) ? _total : MFRC522_TRACE_SIZE;
+} // End Count()
+
+/**
+ * Returns an entry, 0 being the oldest.
+ */
+const MFRC522Trace::Entry &MFRC522Trace::Get(uint16_t index	///< 0 to Count() - 1
+											) const {
+	uint16_t first = (_total < MFRC522_TRACE_SIZE) ? 0 : _next;
+	return _entries[(first + index) % MFRC522_TRACE_SIZE];
+} // End Get()
+
+/**
+ * Returns the number of entries overwritten since Clear().
+ */
+uint32_t MFRC522Trace::Dropped() const {
+	return _total - Count();
+} // End Dropped()
+
+/**
+ * Prints the buffer, oldest entry first. One line per entry:
+ * "<micros> <R|W> <address hex> <count> <first byte hex>". Lines with other content are comments.
+ */
+void MFRC522Trace::Dump(Print &out	///< Serial, a WiFiClient...
+						) const {
+	char line[64];							// Fits the header with 20 digit counts (64 bit long) and the NUL
+	snprintf(line, sizeof(line), "# MFRC522 trace, %u entries, %lu dropped", Count(), (unsigned long)Dropped());
+	out.println(line);
+	for (uint16_t i = 0; i < Count(); i++) {
+		const Entry &entry = Get(i);
+		snprintf(line, sizeof(line), "%lu %c %02X %u %02X", (unsigned long)entry.micros, entry.read ? 'R' : 'W',
+				entry.address, entry.count, entry.value);
+		out.println(line);
+	}
+	out.println("# end of trace");
+} // End Dump()
@@ -0,0 +1,45 @@
+/**
+ * Ring buffer of MFRC522 register operations, to see where a slow card read spends its time.
+ * 
+ * Build with MFRC522_ENABLE_TRACE set to 1 and hand a MFRC522Trace to MFRC522::PCD_SetTrace(). Every register access
+ * that reaches the bus is then recorded with its micros() timestamp; accesses answered from the register shadow are not.
+ * When the buffer is full the oldest entries are overwritten. Dump() prints one line per entry, which
+ * trace_phases.py splits into REQA, select, auth, read, CRC and other phases.
+ * 
+ * Not thread safe: record and dump from the same task.
+ */
+#ifndef MFRC522Trace_h
+#define MFRC522Trace_h
+
+#include <Arduino.h>
+
+#ifndef MFRC522_TRACE_SIZE
+#define MFRC522_TRACE_SIZE (512)		// Entries of 8 bytes. A card read with anticollision and authentication takes about 100.
+#endif
+
+class MFRC522Trace {
+public:
+	struct Entry {
+		uint32_t micros;	// micros() when the access started
+		uint8_t address;	// Register address as in the datasheet, ie PCD_Register >> 1
+		uint8_t count;		// Bytes transferred
+		uint8_t value;		// First byte written or read
+		bool read;
+	};
+	
+	MFRC522Trace();
+	
+	void Record(uint32_t micros, uint8_t reg, bool read, uint8_t count, const uint8_t *values);
+	void Clear();
+	uint16_t Count() const;
+	const Entry &Get(uint16_t index) const;	// 0 is the oldest entry
+	uint32_t Dropped() const;				// Entries overwritten since Clear()
+	void Dump(Print &out) const;
+	
+private:
+	Entry _entries[MFRC522_TRACE_SIZE];
+	uint16_t _next;			// Where the next entry goes
+	uint32_t _total;		// Entries recorded since Clear()
+};
+
+#endif
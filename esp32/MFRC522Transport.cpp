@@ -0,0 +1,94 @@
+/*
+ * MFRC522Transport.cpp - Bus access for the MFRC522 class. See MFRC522Transport.h.
+ */
+#include "MFRC522Transport.h"
+
+#if defined(ARDUINO)
+
+/////////////////////////////////////////////////////////////////////////////////////
+// SPI
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor.
+ */
+MFRC522TransportSPI::MFRC522TransportSPI(	uint8_t chipSelectPin,	///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+											uint32_t clock,			///< SPI clock in Hz
+											SPIClass &spi			///< SPI bus the MFRC522 is on. SPI.begin() must be called by the sketch.
+										) : MFRC522TransportSPIBase(spi), _chipSelectPin(chipSelectPin), _clock(clock) {
+} // End constructor
+
+/**
+ * Sets the chip select pin as output and deselects the MFRC522.
+ */
+void MFRC522TransportSPI::Begin() {
+	pinMode(_chipSelectPin, OUTPUT);
+	digitalWrite(_chipSelectPin, HIGH);
+} // End Begin()
+
+#if !defined(MFRC522_NO_I2C)
+
+/////////////////////////////////////////////////////////////////////////////////////
+// I2C
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Wire buffers are 32 bytes on AVR, so longer transfers are split.
+#define MFRC522_I2C_CHUNK 31
+
+/**
+ * Constructor.
+ */
+MFRC522TransportI2C::MFRC522TransportI2C(	uint8_t address,	///< 7 bit I2C address, set by the EA and D1..D6 pins. 0x28 on most boards.
+											TwoWire &wire		///< I2C bus the MFRC522 is on
+										) : _address(address), _wire(wire) {
+} // End constructor
+
+/**
+ * Nothing to prepare. Wire.begin() is up to the sketch, as SPI.begin() is for SPI.
+ */
+void MFRC522TransportI2C::Begin() {
+} // End Begin()
+
+/**
+ * Writes count bytes to one register. I2C uses the plain register address (datasheet section 8.1.3.3).
+ */
+void MFRC522TransportI2C::WriteRegister(	uint8_t reg,			///< The register to write to. One of the PCD_Register enums.
+											uint8_t count,			///< The number of bytes to write to the register
+											const uint8_t *values	///< The values to write. Byte array.
+										) {
+	uint8_t index = 0;
+	do {
+		uint8_t chunk = count - index;
+		if (chunk > MFRC522_I2C_CHUNK) chunk = MFRC522_I2C_CHUNK;
+		_wire.beginTransmission(_address);
+		_wire.write(reg >> 1);
+		_wire.write(&values[index], chunk);
+		_wire.endTransmission();
+		index += chunk;
+	} while (index < count);
+} // End WriteRegister()
+
+/**
+ * Reads count bytes from one register. The MFRC522 does not increment the address, so FIFODataReg can be
+ * read in one request.
+ */
+void MFRC522TransportI2C::ReadRegister(	uint8_t reg,		///< The register to read from. One of the PCD_Register enums.
+										uint8_t count,		///< The number of bytes to read
+										uint8_t *values		///< Byte array to store the values in.
+									) {
+	uint8_t index = 0;
+	while (index < count) {
+		uint8_t chunk = count - index;
+		if (chunk > MFRC522_I2C_CHUNK) chunk = MFRC522_I2C_CHUNK;
+		_wire.beginTransmission(_address);
+		_wire.write(reg >> 1);
+		_wire.endTransmission(false);		// Repeated start
+		_wire.requestFrom(_address, chunk);
+		for (uint8_t i = 0; i < chunk; i++) {
+			values[index++] = _wire.available() ? _wire.read() : 0;
+		}
+	}
+} // End ReadRegister()
+
+#endif // !MFRC522_NO_I2C
+#endif // ARDUINO
@@ -0,0 +1,215 @@
+/**
+ * Bus access for the MFRC522 class.
+ * 
+ * The MFRC522 speaks SPI, I2C and UART (datasheet section 8.1). The driver only needs to read and write
+ * registers, so everything bus specific lives behind MFRC522Transport. MFRC522TransportSPI is the default and
+ * is what the MFRC522(chipSelectPin, resetPowerDownPin) constructor uses. For other buses construct the
+ * transport yourself and pass it to MFRC522(transport, resetPowerDownPin).
+ * 
+ * Register addresses are always passed as PCD_Register values, ie shifted one bit left as in the SPI address byte.
+ */
+#ifndef MFRC522Transport_h
+#define MFRC522Transport_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+class MFRC522Transport {
+public:
+	virtual ~MFRC522Transport() {}
+	
+	/**
+	 * Prepares the bus and the pins. Called from MFRC522::PCD_Init(), before any register access.
+	 */
+	virtual void Begin() = 0;
+	
+	/**
+	 * Sets the bus clock in Hz. Transports without a configurable clock ignore it.
+	 */
+	virtual void SetClock(uint32_t clock) { (void)clock; }
+	
+	/**
+	 * Writes count bytes to one register. The MFRC522 applies them all to the same address (FIFODataReg).
+	 */
+	virtual void WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) = 0;
+	
+	/**
+	 * Reads count bytes from one register, all from the same address.
+	 */
+	virtual void ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) = 0;
+	
+	/**
+	 * Writes a batch of registers. frames holds [frame length][address][data...] entries, frame length counting the
+	 * address byte, as built by MFRC522::PCD_QueueRegisterWrite(). The buffer may be overwritten.
+	 * The default sends one WriteRegister() per frame. Transports that can chain transfers should override it.
+	 */
+	virtual void WriteFrames(uint8_t *frames, uint8_t length) {
+		uint8_t index = 0;
+		while (index < length) {
+			uint8_t frameLength = frames[index++];
+			WriteRegister(frames[index], frameLength - 1, &frames[index + 1]);
+			index += frameLength;
+		}
+	}
+};
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <SPI.h>
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
+#include <soc/gpio_struct.h>
+#endif
+
+/**
+ * Register access through the Arduino SPI library, shared by MFRC522TransportSPI and MFRC522TransportFastSPI.
+ * Derived supplies Select(), Deselect() and Settings(), so the compile-time variant keeps its chip select inline.
+ * A read is the address byte, then one transfer for all values. A write of up to 32 bytes is one transfer with
+ * the address in front; longer FIFO writes go on in 32 byte chunks. The interface is described in the datasheet section 8.1.2.
+ */
+template <class Derived>
+class MFRC522TransportSPIBase : public MFRC522Transport {
+public:
+	void WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) override {
+		uint8_t buffer[33];					// transfer() overwrites its buffer, so address and values are sent from a copy
+		uint8_t chunk = count < 32 ? count : 32;
+		buffer[0] = reg;					// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
+		memcpy(&buffer[1], values, chunk);
+		_spi.beginTransaction(Bus().Settings());
+		Bus().Select();
+		_spi.transfer(buffer, chunk + 1);
+		for (uint8_t index = chunk; index < count; index += chunk) {
+			chunk = count - index < 32 ? count - index : 32;
+			memcpy(buffer, &values[index], chunk);
+			_spi.transfer(buffer, chunk);
+		}
+		Bus().Deselect();
+		_spi.endTransaction();
+	}
+	
+	void ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) override {
+		if (count == 0) {
+			return;
+		}
+		memset(values, 0x80 | reg, count - 1);	// MSB == 1 is for reading, repeat the address for every byte (section 8.1.2.1)
+		values[count - 1] = 0;				// Send 0 to stop reading
+		_spi.beginTransaction(Bus().Settings());
+		Bus().Select();
+		_spi.transfer(0x80 | reg);			// Tell MFRC522 which address we want to read
+		_spi.transfer(values, count);		// The answer to each byte arrives while the next one is sent
+		Bus().Deselect();
+		_spi.endTransaction();
+	}
+	
+	/**
+	 * Sends all frames inside a single SPI bus transaction. The MFRC522 applies all data bytes of one NSS frame
+	 * to the same address (datasheet section 8.1.2.2), so each register still gets its own chip select pulse.
+	 */
+	void WriteFrames(uint8_t *frames, uint8_t length) override {
+		_spi.beginTransaction(Bus().Settings());
+		uint8_t index = 0;
+		while (index < length) {
+			uint8_t frameLength = frames[index++];
+			Bus().Select();
+			_spi.transfer(&frames[index], frameLength);	// Address and data in one buffer. The received bytes overwrite the frames, which are not needed anymore.
+			Bus().Deselect();
+			index += frameLength;
+		}
+		_spi.endTransaction();
+	}
+	
+protected:
+	MFRC522TransportSPIBase(SPIClass &spi) : _spi(spi) {}
+	
+	SPIClass &_spi;
+	
+private:
+	Derived &Bus() { return static_cast<Derived &>(*this); }
+};
+
+/**
+ * SPI with a GPIO as chip select, set at run time. This is what MFRC522(chipSelectPin, resetPowerDownPin) uses.
+ */
+class MFRC522TransportSPI : public MFRC522TransportSPIBase<MFRC522TransportSPI> {
+	friend class MFRC522TransportSPIBase<MFRC522TransportSPI>;
+public:
+	MFRC522TransportSPI(uint8_t chipSelectPin, uint32_t clock, SPIClass &spi = SPI);
+	
+	void Begin() override;
+	void SetClock(uint32_t clock) override { _clock = clock; }
+	
+	void SetChipSelectPin(uint8_t chipSelectPin) { _chipSelectPin = chipSelectPin; }
+	
+private:
+	uint8_t _chipSelectPin;		// Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+	uint32_t _clock;			// SPI clock in Hz
+	
+	void Select() { digitalWrite(_chipSelectPin, LOW); }
+	void Deselect() { digitalWrite(_chipSelectPin, HIGH); }
+	SPISettings Settings() const { return SPISettings(_clock, MSBFIRST, SPI_MODE0); }
+};
+
+/**
+ * SPI with chip select pin and clock fixed at compile time, eg MFRC522TransportFastSPI<5, 8000000u>.
+ * On the ESP32 chip select is driven through the GPIO set/clear registers instead of digitalWrite(),
+ * other cores fall back to digitalWrite(). The clock cannot be changed, so PCD_SetSPIClock() and
+ * PCD_CalibrateSPIClock() have no effect; use the calibration with MFRC522TransportSPI to find the value.
+ */
+template <uint8_t CS_PIN, uint32_t CLOCK>
+class MFRC522TransportFastSPI : public MFRC522TransportSPIBase<MFRC522TransportFastSPI<CS_PIN, CLOCK> > {
+	static_assert(CLOCK > 0 && CLOCK <= 10000000u, "The MFRC522 accepts up to 10MHz");
+	friend class MFRC522TransportSPIBase<MFRC522TransportFastSPI<CS_PIN, CLOCK> >;
+public:
+	MFRC522TransportFastSPI(SPIClass &spi = SPI) : MFRC522TransportSPIBase<MFRC522TransportFastSPI<CS_PIN, CLOCK> >(spi) {}
+	
+	void Begin() override {
+		pinMode(CS_PIN, OUTPUT);
+		Deselect();
+	}
+	
+private:
+	static inline void Select() {
+#if defined(CONFIG_IDF_TARGET_ESP32)
+		if (CS_PIN < 32) GPIO.out_w1tc = (uint32_t)1 << (CS_PIN & 31);
+		else GPIO.out1_w1tc.val = (uint32_t)1 << (CS_PIN & 31);
+#else
+		digitalWrite(CS_PIN, LOW);
+#endif
+	}
+	
+	static inline void Deselect() {
+#if defined(CONFIG_IDF_TARGET_ESP32)
+		if (CS_PIN < 32) GPIO.out_w1ts = (uint32_t)1 << (CS_PIN & 31);
+		else GPIO.out1_w1ts.val = (uint32_t)1 << (CS_PIN & 31);
+#else
+		digitalWrite(CS_PIN, HIGH);
+#endif
+	}
+	
+	static SPISettings Settings() { return SPISettings(CLOCK, MSBFIRST, SPI_MODE0); }
+};
+
+#if !defined(MFRC522_NO_I2C)
+#include <Wire.h>
+
+/**
+ * I2C through the Arduino Wire library. Pins 1 (I2C) and 32 (EA) of the MFRC522 select the bus and address,
+ * see datasheet section 8.1.3. Most RC522 breakout boards are wired for SPI and need rework for this.
+ * Call Wire.begin() (and Wire.setClock(), up to 400kHz) before PCD_Init(). PCD_SetSPIClock() has no effect.
+ */
+class MFRC522TransportI2C : public MFRC522Transport {
+public:
+	MFRC522TransportI2C(uint8_t address = 0x28, TwoWire &wire = Wire);
+	
+	void Begin() override;
+	void WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) override;
+	void ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) override;
+	
+private:
+	uint8_t _address;			// 7 bit I2C address
+	TwoWire &_wire;
+};
+#endif // !MFRC522_NO_I2C
+#endif // ARDUINO
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * MFRC522TransportSpidev.cpp - Linux spidev transport for the MFRC522 class. See MFRC522TransportSpidev.h.
+ */
+#include "MFRC522TransportSpidev.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+// Transfers per SPI_IOC_MESSAGE in WriteFrames(). Each frame is at least 2 bytes, so the register queue never needs more.
+#define MFRC522_SPIDEV_MAX_FRAMES 32
+
+/**
+ * Constructor. Nothing is opened before Begin().
+ */
+MFRC522TransportSpidev::MFRC522TransportSpidev(	const char *device,	///< spidev device node, e.g. "/dev/spidev0.0"
+												uint32_t clock		///< SPI clock in Hz. The MFRC522 accepts up to 10MHz.
+											) : _device(device), _fd(-1), _clock(clock) {
+} // End constructor
+
+/**
+ * Destructor. Closes the device.
+ */
+MFRC522TransportSpidev::~MFRC522TransportSpidev() {
+	if (_fd >= 0) {
+		close(_fd);
+	}
+} // End destructor
+
+/**
+ * Opens the device and sets SPI mode 0, 8 bits per word, MSB first.
+ * On failure the device stays closed, reads return 0 and VersionReg reads as 0x00. Check IsOpen().
+ */
+void MFRC522TransportSpidev::Begin() {
+	if (_fd >= 0) {
+		return;							// PCD_Init() runs again after every reset
+	}
+	_fd = open(_device, O_RDWR);
+	if (_fd < 0) {
+		return;
+	}
+	uint8_t mode = SPI_MODE_0;
+	uint8_t bits = 8;
+	if (ioctl(_fd, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+		ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &_clock) < 0) {
+		close(_fd);
+		_fd = -1;
+	}
+} // End Begin()
+
+/**
+ * Writes count bytes to one register in a single transfer.
+ */
+void MFRC522TransportSpidev::WriteRegister(	uint8_t reg,			///< The register to write to. One of the PCD_Register enums.
+											uint8_t count,			///< The number of bytes to write to the register
+											const uint8_t *values	///< The values to write. Byte array.
+										) {
+	uint8_t buffer[256];
+	buffer[0] = reg;						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
+	memcpy(&buffer[1], values, count);
+	
+	struct spi_ioc_transfer transfer;
+	memset(&transfer, 0, sizeof(transfer));
+	transfer.tx_buf = (unsigned long)buffer;
+	transfer.len = count + 1;
+	transfer.speed_hz = _clock;
+	transfer.bits_per_word = 8;
+	if (_fd >= 0) {
+		ioctl(_fd, SPI_IOC_MESSAGE(1), &transfer);
+	}
+} // End WriteRegister()
+
+/**
+ * Reads count bytes from one register in a single transfer.
+ * Each byte sent repeats the read address, the last one is 0 to stop reading (datasheet section 8.1.2.1).
+ */
+void MFRC522TransportSpidev::ReadRegister(	uint8_t reg,		///< The register to read from. One of the PCD_Register enums.
+											uint8_t count,		///< The number of bytes to read
+											uint8_t *values		///< Byte array to store the values in.
+										) {
+	uint8_t tx[256];
+	uint8_t rx[256];
+	memset(tx, 0x80 | reg, count);			// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
+	tx[count] = 0;
+	memset(rx, 0, count + 1);
+	
+	struct spi_ioc_transfer transfer;
+	memset(&transfer, 0, sizeof(transfer));
+	transfer.tx_buf = (unsigned long)tx;
+	transfer.rx_buf = (unsigned long)rx;
+	transfer.len = count + 1;
+	transfer.speed_hz = _clock;
+	transfer.bits_per_word = 8;
+	if (_fd >= 0) {
+		ioctl(_fd, SPI_IOC_MESSAGE(1), &transfer);
+	}
+	memcpy(values, &rx[1], count);			// rx[0] arrived while the address was sent
+} // End ReadRegister()
+
+/**
+ * Sends all frames with one ioctl. cs_change releases chip select between the transfers, since the MFRC522
+ * applies all data bytes of one NSS frame to the same address (datasheet section 8.1.2.2).
+ */
+void MFRC522TransportSpidev::WriteFrames(	uint8_t *frames,	///< [frame length][address][data...] entries
+											uint8_t length		///< Number of bytes in frames
+										) {
+	struct spi_ioc_transfer transfers[MFRC522_SPIDEV_MAX_FRAMES];
+	uint8_t index = 0;
+	while (index < length) {
+		unsigned count = 0;
+		memset(transfers, 0, sizeof(transfers));
+		do {									// At least one frame, the outer loop checked index
+			uint8_t frameLength = frames[index++];
+			transfers[count].tx_buf = (unsigned long)&frames[index];
+			transfers[count].len = frameLength;
+			transfers[count].speed_hz = _clock;
+			transfers[count].bits_per_word = 8;
+			transfers[count].cs_change = 1;		// Deselect after this transfer
+			index += frameLength;
+			count++;
+		} while (index < length && count < MFRC522_SPIDEV_MAX_FRAMES);
+		transfers[count - 1].cs_change = 0;		// The last transfer deselects anyway
+		if (_fd >= 0) {
+			ioctl(_fd, SPI_IOC_MESSAGE(count), transfers);
+		}
+	}
+} // End WriteFrames()
+
+#endif // __linux__
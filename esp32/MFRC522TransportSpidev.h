@@ -0,0 +1,37 @@
+/**
+ * Linux spidev transport for the MFRC522 class, for single board computers (Raspberry Pi, NanoPC-T4, ...).
+ * 
+ * Every register access is a single SPI_IOC_MESSAGE ioctl, and a flushed register queue goes out as one ioctl
+ * with one transfer per register. Per-byte transfers from user space cost a system call each.
+ * 
+ * Chip select is handled by the kernel driver, so use the CE line of the spidev device (e.g. /dev/spidev0.0).
+ * Only compiled on Linux; on Arduino cores this file is empty. linux/ provides the Arduino functions the driver needs,
+ * see linux/read_uid.cpp for an example and the README for the build line.
+ */
+#ifndef MFRC522TransportSpidev_h
+#define MFRC522TransportSpidev_h
+
+#if defined(__linux__)
+#include "MFRC522Transport.h"
+
+class MFRC522TransportSpidev : public MFRC522Transport {
+public:
+	MFRC522TransportSpidev(const char *device, uint32_t clock = 4000000u);
+	~MFRC522TransportSpidev();
+	
+	void Begin() override;
+	void SetClock(uint32_t clock) override { _clock = clock; }
+	void WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) override;
+	void ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) override;
+	void WriteFrames(uint8_t *frames, uint8_t length) override;
+	
+	bool IsOpen() const { return _fd >= 0; }		// False if Begin() could not open or configure the device
+	
+private:
+	const char *_device;		// Path of the spidev device node
+	int _fd;					// File descriptor, -1 while closed
+	uint32_t _clock;			// SPI clock in Hz
+};
+
+#endif // __linux__
+#endif
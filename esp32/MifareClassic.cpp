@@ -0,0 +1,163 @@
+#include "MifareClassic.h"
+
+MifareClassic::MifareClassic(MFRC522& reader) : mfrc522(reader) {
+    memset(key.keyByte, 0xFF, sizeof(key.keyByte));
+}
+
+void MifareClassic::Begin(const MFRC522::MIFARE_Key& key) {
+    this->key = key;
+    authenticatedSector = -1;
+    authCount = 0;
+    blockCount = BlockCount(MFRC522::PICC_GetType(mfrc522.uid.sak));
+}
+
+void MifareClassic::End() {
+    mfrc522.PICC_HaltA();
+    mfrc522.PCD_StopCrypto1();
+    authenticatedSector = -1;
+}
+
+bool MifareClassic::IsTrailer(byte block) {
+    // Sectors 0-31 have 4 blocks, sectors 32-39 (4K cards only) have 16 blocks
+    if (block < 128) return (block % 4) == 3;
+    return ((block - 128) % 16) == 15;
+}
+
+byte MifareClassic::SectorOf(byte block) {
+    if (block < 128) return block / 4;
+    return 32 + (block - 128) / 16;
+}
+
+uint16_t MifareClassic::BlockCount(MFRC522::PICC_Type type) {
+    switch (type) {
+        case MFRC522::PICC_TYPE_MIFARE_MINI: return 20;
+        case MFRC522::PICC_TYPE_MIFARE_1K:   return 64;
+        case MFRC522::PICC_TYPE_MIFARE_4K:   return 256;
+        default:                             return 0;
+    }
+}
+
+int MifareClassic::Read(byte firstBlock, byte* out, size_t maxLen) {
+    unsigned long start = micros();
+    size_t len = 0;
+    failure = FAILURE_NONE;
+    failedStatus = MFRC522::STATUS_OK;
+    bool ok = blockCount > 0;
+    if (!ok) Fail(FAILURE_NOT_CLASSIC, firstBlock, MFRC522::STATUS_INVALID);
+
+    for (uint16_t block = firstBlock; ok && block < blockCount && len + 16 <= maxLen; block++) {
+        if (IsTrailer(block)) continue;
+        if (!EnsureSector(block)) { ok = false; break; }
+
+        byte buffer[18];
+        byte size = sizeof(buffer);
+        MFRC522::StatusCode status = mfrc522.MIFARE_Read(block, buffer, &size);
+        if (status != MFRC522::STATUS_OK) {
+            Fail(FAILURE_READ, block, status);
+            authenticatedSector = -1;   // The card drops out of the authenticated state on errors
+            ok = false;
+            break;
+        }
+
+        bool empty = true;
+        for (byte i = 0; i < 16; i++) {
+            if (buffer[i] != 0) { empty = false; break; }
+        }
+        if (empty) break;               // End of data
+
+        memcpy(out + len, buffer, 16);
+        len += 16;
+    }
+
+    lastDuration = micros() - start;
+    return ok ? (int)len : -1;
+}
+
+bool MifareClassic::Write(byte firstBlock, const byte* data, size_t len) {
+    unsigned long start = micros();
+    size_t offset = 0;
+    bool terminated = (len % 16) != 0;  // A partial last block already ends in zeros
+    failure = FAILURE_NONE;
+    failedStatus = MFRC522::STATUS_OK;
+    bool ok = blockCount > 0;
+    if (!ok) Fail(FAILURE_NOT_CLASSIC, firstBlock, MFRC522::STATUS_INVALID);
+
+    for (uint16_t block = firstBlock; ok && block < blockCount; block++) {
+        if (block == 0 || IsTrailer(block)) continue;   // Never touch the manufacturer block or the keys
+        if (offset >= len && terminated) break;
+
+        byte buffer[16];
+        size_t chunk = (len - offset > 16) ? 16 : (len - offset);
+        memset(buffer, 0, sizeof(buffer));
+        memcpy(buffer, data + offset, chunk);
+
+        if (!EnsureSector(block)) { ok = false; break; }
+        MFRC522::StatusCode status = mfrc522.MIFARE_Write(block, buffer, 16);
+        if (status != MFRC522::STATUS_OK) {
+            Fail(FAILURE_WRITE, block, status);
+            authenticatedSector = -1;
+            ok = false;
+            break;
+        }
+
+        if (offset >= len) terminated = true;   // That was the all-zero end marker
+        offset += chunk;
+    }
+
+    // Running out of card before everything is written is an error, a missing end marker is not
+    if (ok && offset < len) {
+        Fail(FAILURE_CARD_FULL, blockCount - 1, MFRC522::STATUS_NO_ROOM);
+        ok = false;
+    }
+    lastDuration = micros() - start;
+    return ok;
+}
+
+bool MifareClassic::EnsureSector(byte block) {
+    byte sector = SectorOf(block);
+    if (authenticatedSector == sector) return true;
+
+    MFRC522::StatusCode status = MFRC522::STATUS_TIMEOUT;   // Stays so if the card cannot even be selected again
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (attempt > 0 && !Reselect()) continue;
+        authCount++;
+        status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, &key, &mfrc522.uid);
+        if (status == MFRC522::STATUS_OK) {
+            authenticatedSector = sector;
+            return true;
+        }
+    }
+    Fail(FAILURE_AUTH, block, status);
+    authenticatedSector = -1;
+    return false;
+}
+
+void MifareClassic::Fail(Failure what, byte block, MFRC522::StatusCode status) {
+    failure = what;
+    failedBlock = block;
+    failedStatus = status;
+}
+
+String MifareClassic::GetLastError() const {
+    String what;
+    switch (failure) {
+        case FAILURE_NONE:        return String();
+        case FAILURE_NOT_CLASSIC: return "Not a MIFARE Classic card";
+        case FAILURE_AUTH:        what = "Authentication failed for sector " + String(SectorOf(failedBlock)); break;
+        case FAILURE_READ:        what = "Read failed at block " + String(failedBlock); break;
+        case FAILURE_WRITE:       what = "Write failed at block " + String(failedBlock); break;
+        case FAILURE_CARD_FULL:   return "Data does not fit on the card";
+    }
+    return what + ": " + String(MFRC522::GetStatusCodeName(failedStatus));
+}
+
+bool MifareClassic::Reselect() {
+    // A failed authentication leaves the card in HALT, so a plain retry cannot succeed
+    mfrc522.PCD_StopCrypto1();
+    authenticatedSector = -1;
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    if (mfrc522.PICC_WakeupA(atqa, &atqaSize) != MFRC522::STATUS_OK) return false;
+    MFRC522::Uid uid = mfrc522.uid;
+    return mfrc522.PICC_Select(&uid, uid.size * 8) == MFRC522::STATUS_OK;
+}
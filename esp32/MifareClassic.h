@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+#include "MFRC522.h"
+
+// Sector-aware block I/O for MIFARE Classic cards.
+// Authenticates once per sector instead of once per block and never touches sector trailers.
+class MifareClassic {
+public:
+    MifareClassic(MFRC522& reader);
+
+    void Begin(const MFRC522::MIFARE_Key& key);        // Starts a session with the currently selected card
+    void End();                                        // Halts the card and stops Crypto1
+
+    // Reads data blocks from firstBlock on, skipping trailers, until an all-zero block,
+    // maxLen bytes or the end of the card. Returns the number of bytes read, or -1 on error.
+    int Read(byte firstBlock, byte* out, size_t maxLen);
+    // Writes len bytes from firstBlock on, skipping trailers. The last block is zero padded.
+    // If len is a multiple of 16 an all-zero block is written after the data so Read() stops there.
+    bool Write(byte firstBlock, const byte* data, size_t len);
+
+    static bool IsTrailer(byte block);                 // True for the sector trailer blocks
+    static byte SectorOf(byte block);                  // Sector that holds the block
+    static uint16_t BlockCount(MFRC522::PICC_Type type); // Number of blocks on the card, 0 if not MIFARE Classic
+
+    unsigned long GetAuthCount() const { return authCount; }              // Authentications since Begin()
+    unsigned long GetLastDurationMicros() const { return lastDuration; }  // Time spent in the last Read() or Write()
+    MFRC522::StatusCode GetLastStatus() const { return failedStatus; }    // Why the last Read() or Write() failed, STATUS_OK if it did not
+    String GetLastError() const;                                         // The same as a message for the log, empty if it did not fail
+
+private:
+    enum Failure : byte { FAILURE_NONE, FAILURE_NOT_CLASSIC, FAILURE_AUTH, FAILURE_READ, FAILURE_WRITE, FAILURE_CARD_FULL };
+
+    MFRC522& mfrc522;
+    MFRC522::MIFARE_Key key;
+    int authenticatedSector = -1;   // Sector Crypto1 is currently set up for, -1 for none
+    uint16_t blockCount = 0;        // Blocks on the card, from the SAK
+    unsigned long authCount = 0;
+    unsigned long lastDuration = 0;
+    Failure failure = FAILURE_NONE;
+    byte failedBlock = 0;
+    MFRC522::StatusCode failedStatus = MFRC522::STATUS_OK;
+
+    bool EnsureSector(byte block);  // Authenticates the sector of block unless it already is
+    void Fail(Failure what, byte block, MFRC522::StatusCode status);
+    bool Reselect();                // Wakes and selects the card again after a failed authentication
+};
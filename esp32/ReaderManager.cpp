@@ -0,0 +1,80 @@
+#include "ReaderManager.h"
+
+int ReaderManager::Add(MFRC522& reader, unsigned long readBudgetMs) {
+    if (slotCount >= MAX_SLOTS) return -1;
+    slots[slotCount].reader = &reader;
+    if (readBudgetMs < 2UL * HALT_RESERVE_MS) readBudgetMs = 2UL * HALT_RESERVE_MS;
+    slots[slotCount].readBudgetMs = readBudgetMs;
+    return slotCount++;
+}
+
+void ReaderManager::Begin() {
+    for (byte i = 0; i < slotCount; i++) {
+        slots[i].reader->PCD_Init();
+        byte version = slots[i].reader->PCD_ReadRegister(MFRC522::VersionReg);
+        if (version == 0x00 || version == 0xFF) {
+            Serial.println("[ReaderManager] Slot " + String(i) + " not responding");
+        }
+    }
+}
+
+void ReaderManager::Poll(CardHandler handler) {
+    if (slotCount == 0) return;
+    byte index = next;
+    next = (next + 1) % slotCount;
+
+    Slot& slot = slots[index];
+    MFRC522& reader = *slot.reader;
+    slot.stats.polls++;
+
+    unsigned long turnStart = millis();
+    unsigned long turnEnd = turnStart + slot.readBudgetMs;
+    uint32_t deadlines = reader.PCD_GetErrorCounters().deadlines;
+    reader.PCD_SetDeadline(turnEnd - HALT_RESERVE_MS);
+
+    unsigned long start = micros();
+    if (!reader.PICC_IsNewCardPresent()) {
+        reader.PCD_ClearDeadline();
+        unsigned long elapsed = micros() - start;
+        if (elapsed > slot.stats.maxPollMicros) slot.stats.maxPollMicros = elapsed;
+        return;
+    }
+    bool ok = reader.PICC_ReadCardSerial();
+    if (ok) {
+        slot.stats.cards++;
+        start = micros();
+        ok = handler(index, reader);
+        unsigned long elapsed = micros() - start;
+        if (elapsed > slot.stats.maxReadMicros) slot.stats.maxReadMicros = elapsed;
+    }
+    if (!ok) slot.stats.readErrors++;
+    if (reader.PCD_GetErrorCounters().deadlines != deadlines) slot.stats.budgetCutoffs++;
+
+    reader.PCD_SetDeadline(turnEnd);                // The HLTA gets the time kept back for it
+    reader.PICC_HaltA();
+    reader.PCD_StopCrypto1();
+    reader.PCD_ClearDeadline();
+    if (millis() - turnStart > slot.readBudgetMs) slot.stats.budgetOverruns++;
+}
+
+unsigned long ReaderManager::GetWorstCaseLatencyMicros(byte slot) const {
+    // A card arriving just after its slot sent REQA waits for the rest of that turn and one turn of
+    // every other slot. A turn ends at its deadline, plus up to 1ms because millis() is what is checked.
+    (void)slot;
+    unsigned long total = 0;
+    for (byte i = 0; i < slotCount; i++) {
+        total += (slots[i].readBudgetMs + 1) * 1000UL;
+    }
+    return total;
+}
+
+void ReaderManager::PrintStats(Print& out) const {
+    for (byte i = 0; i < slotCount; i++) {
+        const Stats& s = slots[i].stats;
+        out.printf("[ReaderManager] Slot %u: %lu polls, %lu cards, %lu errors, %lu cut off, %lu overruns, poll max %lu us, read max %lu us, worst case latency %lu us\n",
+                   i, s.polls, s.cards, s.readErrors, s.budgetCutoffs, s.budgetOverruns, s.maxPollMicros, s.maxReadMicros, GetWorstCaseLatencyMicros(i));
+        const MFRC522::PCD_ErrorCounters& e = slots[i].reader->PCD_GetErrorCounters();
+        out.printf("[ReaderManager] Slot %u: %lu chip timeouts, %lu CRC, %lu collisions, %lu NACKs, %lu other errors, %lu resets\n",
+                   i, e.chipTimeouts, e.crcErrors, e.collisions, e.nacks, e.errors, e.recoveries);
+    }
+}
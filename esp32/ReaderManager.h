@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "MFRC522.h"
+
+// Several RC522 readers ("slots") on one SPI bus, each with its own SS pin.
+// Poll() checks one slot per call, round robin. Each turn, from REQA to the HLTA that ends it, runs under
+// a reader deadline (MFRC522::PCD_SetDeadline()) of the slot's read budget: reader commands that would run
+// past it are cut short or not sent. A card on any slot is therefore seen within GetWorstCaseLatencyMicros(),
+// one turn of every slot, as long as the handler only waits on the reader. Time the handler spends on other
+// things (logging, flash, network) is not cut off; turns that went over budget that way count in budgetOverruns.
+class ReaderManager {
+public:
+    static const byte MAX_SLOTS = 8;
+    static const byte HALT_RESERVE_MS = 2;  // Part of the budget kept back for the HLTA that ends a turn
+
+    struct Stats {
+        unsigned long polls = 0;            // PICC_IsNewCardPresent() calls
+        unsigned long cards = 0;            // Cards detected and handed to the handler
+        unsigned long readErrors = 0;       // Handler or PICC_ReadCardSerial() failures
+        unsigned long budgetCutoffs = 0;    // Turns in which the deadline stopped a reader command
+        unsigned long budgetOverruns = 0;   // Turns that took longer than the budget anyway, see above
+        unsigned long maxPollMicros = 0;    // Longest empty poll
+        unsigned long maxReadMicros = 0;    // Longest handler call
+    };
+
+    // Called with the card selected (reader.uid is valid). Returns false if reading the card failed.
+    typedef bool (*CardHandler)(byte slot, MFRC522& reader);
+
+    // readBudgetMs is the time a turn on this slot may take, card read included, which bounds how long
+    // the other slots wait. At least 2 * HALT_RESERVE_MS. Returns the slot number, or -1 if all slots are in use.
+    int Add(MFRC522& reader, unsigned long readBudgetMs = 100);
+    void Begin();                                   // PCD_Init() on every slot. Readers sharing a RST pin are reset together, so do this once.
+    void Poll(CardHandler handler);                 // Polls the next slot
+
+    byte GetSlotCount() const { return slotCount; }
+    const Stats& GetStats(byte slot) const { return slots[slot].stats; }
+    unsigned long GetWorstCaseLatencyMicros(byte slot) const;
+    void PrintStats(Print& out) const;
+
+private:
+    struct Slot {
+        MFRC522* reader = nullptr;
+        unsigned long readBudgetMs = 0;
+        Stats stats;
+    };
+
+    Slot slots[MAX_SLOTS];
+    byte slotCount = 0;
+    byte next = 0;                                  // Slot the next Poll() checks
+};
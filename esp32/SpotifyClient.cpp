@@ -137,6 +137,23 @@ int SpotifyClient::Shuffle() {
     return result.httpCode;
 }
 
+int SpotifyClient::Queue(String uri) {
+    Serial.println("[SpotifyClient] Queue()");
+    if (!EnsureTokenFresh()) {
+        Serial.println("[SpotifyClient] Cannot queue without a valid token.");
+        return 401;
+    }
+    if (deviceId.isEmpty()) {
+        GetDevices();
+        if (deviceId.isEmpty()) {
+            Serial.println("[SpotifyClient] Error: Unable to set deviceId. Aborting queue.");
+            return 404;
+        }
+    }
+    HttpResult result = CallAPI("POST", "https://api.spotify.com/v1/me/player/queue?uri=" + uri + "&device_id=" + deviceId, "");
+    return result.httpCode;
+}
+
 int SpotifyClient::Next() {
     Serial.println("[SpotifyClient] Next()");
     if (!EnsureTokenFresh()) {
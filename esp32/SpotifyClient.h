@@ -13,6 +13,7 @@ public:
 
     void FetchToken();                               // Fetches a new access token
     int Play(String context_uri);                    // Starts playback of a given context
+    int Queue(String uri);                           // Adds a track or episode to the playback queue
     int Shuffle();                                   // Enables shuffle on the active device
     int Next();                                      // Skips to the next track
     String GetDevices();                             // Fetches a list of devices and sets the active device
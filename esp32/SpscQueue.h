@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free ring buffer for exactly one producer and one consumer, which may run on different cores.
+// Holds up to N - 1 items. Push() and Pop() never block; they fail when the queue is full or empty.
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    bool Push(const T& item) {                          // Producer side only
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t next = (h + 1) % N;
+        if (next == tail.load(std::memory_order_acquire)) return false;
+        items[h] = item;
+        head.store(next, std::memory_order_release);    // Publishes the item to the consumer
+        return true;
+    }
+
+    bool Pop(T& item) {                                 // Consumer side only
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = items[t];
+        tail.store((t + 1) % N, std::memory_order_release);  // Hands the slot back to the producer
+        return true;
+    }
+
+    bool IsEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+    T items[N];
+    std::atomic<size_t> head{0};    // Next slot to write, owned by the producer
+    std::atomic<size_t> tail{0};    // Next slot to read, owned by the consumer
+};
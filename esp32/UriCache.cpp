@@ -0,0 +1,168 @@
+#include "UriCache.h"
+
+bool UriCache::Begin() {
+    started = prefs.begin("uricache", false);
+    if (!started) return false;
+    if (prefs.isKey("index")) {
+        nvsCount = prefs.getBytes("index", nvsIndex, sizeof(nvsIndex)) / sizeof(nvsIndex[0]);
+    } else {
+        prefs.clear();      // Entries stored before there was an index could never be evicted
+    }
+    return true;
+}
+
+bool UriCache::Lookup(const MFRC522::Uid& uid, String& uri, uint32_t& checksum) {
+    Entry* entry = Find(uid);
+    if (!entry && started) {
+        // NVS record: [uid size][uid][checksum, 4 bytes LE][uri]
+        String key = Key(KeyHash(uid));
+        size_t len = prefs.getBytesLength(key.c_str());
+        if (len > (size_t)uid.size + 5) {
+            byte* record = new byte[len + 1];
+            prefs.getBytes(key.c_str(), record, len);
+            if (record[0] == uid.size && memcmp(record + 1, uid.uidByte, uid.size) == 0) {
+                const byte* p = record + 1 + uid.size;
+                uint32_t storedChecksum = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+                record[len] = 0;
+                entry = Put(uid, String((const char*)(p + 4)), storedChecksum);
+            }
+            delete[] record;
+        }
+    }
+
+    if (!entry) {
+        misses++;
+        return false;
+    }
+    hits++;
+    entry->lastUsed = millis();
+    uri = entry->uri;
+    checksum = entry->checksum;
+    return true;
+}
+
+bool UriCache::Store(const MFRC522::Uid& uid, const String& uri, uint32_t checksum) {
+    Entry* entry = Find(uid);
+    if (entry && entry->checksum == checksum && entry->uri == uri) {
+        return true;    // Already cached, spare the flash a write
+    }
+    Put(uid, uri, checksum);
+
+    if (!started) return true;
+    uint32_t hash = KeyHash(uid);
+    Track(hash);        // Before writing, so an evicted entry makes room
+    size_t len = 1 + uid.size + 4 + uri.length();
+    byte* record = new byte[len];
+    record[0] = uid.size;
+    memcpy(record + 1, uid.uidByte, uid.size);
+    byte* p = record + 1 + uid.size;
+    for (byte i = 0; i < 4; i++) p[i] = (checksum >> (8 * i)) & 0xFF;
+    memcpy(p + 4, uri.c_str(), uri.length());
+    bool stored = prefs.putBytes(Key(hash).c_str(), record, len) == len;
+    delete[] record;
+    if (!stored) Untrack(hash);
+    return stored;
+}
+
+void UriCache::Remove(const MFRC522::Uid& uid) {
+    Entry* entry = Find(uid);
+    if (entry) entry->uidSize = 0;
+    if (!started) return;
+    uint32_t hash = KeyHash(uid);
+    prefs.remove(Key(hash).c_str());
+    Untrack(hash);
+}
+
+uint32_t UriCache::Checksum(const byte* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void UriCache::BuildHeader(const String& text, byte header[16]) {
+    // 'S' 'U' | version | text length (0 if over 255) | checksum, 4 bytes LE | zero
+    uint32_t checksum = Checksum((const byte*)text.c_str(), text.length());
+    memset(header, 0, 16);
+    header[0] = 'S';
+    header[1] = 'U';
+    header[2] = HEADER_VERSION;
+    header[3] = text.length() > 255 ? 0 : text.length();
+    for (byte i = 0; i < 4; i++) header[4 + i] = (checksum >> (8 * i)) & 0xFF;
+}
+
+bool UriCache::ParseHeader(const byte header[16], uint32_t& checksum) {
+    if (header[0] != 'S' || header[1] != 'U' || header[2] != HEADER_VERSION) return false;
+    checksum = header[4] | (header[5] << 8) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 24);
+    return true;
+}
+
+UriCache::Entry* UriCache::Find(const MFRC522::Uid& uid) {
+    for (byte i = 0; i < RAM_ENTRIES; i++) {
+        if (entries[i].uidSize == uid.size && memcmp(entries[i].uid, uid.uidByte, uid.size) == 0) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+UriCache::Entry* UriCache::Put(const MFRC522::Uid& uid, const String& uri, uint32_t checksum) {
+    Entry* entry = Find(uid);
+    if (!entry) {
+        entry = &entries[0];
+        for (byte i = 0; i < RAM_ENTRIES; i++) {
+            if (entries[i].uidSize == 0) { entry = &entries[i]; break; }
+            if (entries[i].lastUsed < entry->lastUsed) entry = &entries[i];
+        }
+    }
+    memcpy(entry->uid, uid.uidByte, uid.size);
+    entry->uidSize = uid.size;
+    entry->uri = uri;
+    entry->checksum = checksum;
+    entry->lastUsed = millis();
+    return entry;
+}
+
+void UriCache::Track(uint32_t hash) {
+    for (byte i = 0; i < nvsCount; i++) {
+        if (nvsIndex[i] == hash) return;    // Rewritten card, keeps its place
+    }
+    if (nvsCount == NVS_ENTRIES) {
+        prefs.remove(Key(nvsIndex[0]).c_str());
+        memmove(nvsIndex, nvsIndex + 1, (NVS_ENTRIES - 1) * sizeof(nvsIndex[0]));
+        nvsCount--;
+        evictions++;
+    }
+    nvsIndex[nvsCount++] = hash;
+    SaveIndex();
+}
+
+void UriCache::Untrack(uint32_t hash) {
+    for (byte i = 0; i < nvsCount; i++) {
+        if (nvsIndex[i] != hash) continue;
+        memmove(nvsIndex + i, nvsIndex + i + 1, (nvsCount - i - 1) * sizeof(nvsIndex[0]));
+        nvsCount--;
+        SaveIndex();
+        return;
+    }
+}
+
+void UriCache::SaveIndex() {
+    if (nvsCount) {
+        prefs.putBytes("index", nvsIndex, nvsCount * sizeof(nvsIndex[0]));
+    } else {
+        prefs.remove("index");              // NVS does not store empty blobs
+    }
+}
+
+uint32_t UriCache::KeyHash(const MFRC522::Uid& uid) {
+    return Checksum(uid.uidByte, uid.size);
+}
+
+String UriCache::Key(uint32_t hash) {
+    char key[12];
+    snprintf(key, sizeof(key), "u%08lx", (unsigned long)hash);
+    return String(key);
+}
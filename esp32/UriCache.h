@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "MFRC522.h"
+
+// UID -> URI cache, kept in RAM and backed by NVS so it survives reboots.
+// Cards written by rfid_spotifyuri_writer carry a header block with a checksum of their text,
+// which is how a cached entry is checked against a card that may have been rewritten since.
+// NVS holds at most NVS_ENTRIES cards. A new card beyond that replaces the one stored longest ago.
+class UriCache {
+public:
+    static const byte HEADER_BLOCK = 1;     // Block 1, sector 0. Block 0 is the manufacturer block.
+    static const byte HEADER_VERSION = 1;
+    static const byte NVS_ENTRIES = 64;
+
+    bool Begin();                                                           // Opens the NVS namespace, false if caching in RAM only
+
+    bool Lookup(const MFRC522::Uid& uid, String& uri, uint32_t& checksum);  // RAM first, then NVS
+    bool Store(const MFRC522::Uid& uid, const String& uri, uint32_t checksum);  // False if NVS could not take it
+    void Remove(const MFRC522::Uid& uid);
+
+    static uint32_t Checksum(const byte* data, size_t len);                 // FNV-1a
+    static void BuildHeader(const String& text, byte header[16]);           // Header block for the text written to the card
+    static bool ParseHeader(const byte header[16], uint32_t& checksum);     // False if the block is not a header
+
+    unsigned long GetHits() const { return hits; }
+    unsigned long GetMisses() const { return misses; }
+    unsigned long GetEvictions() const { return evictions; }                // NVS entries dropped for newer cards
+
+private:
+    static const byte RAM_ENTRIES = 16;
+
+    struct Entry {
+        byte uid[10];
+        byte uidSize = 0;                   // 0 marks a free entry
+        uint32_t checksum = 0;
+        String uri;
+        unsigned long lastUsed = 0;
+    };
+
+    Entry entries[RAM_ENTRIES];
+    Preferences prefs;
+    bool started = false;
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    unsigned long evictions = 0;
+    uint32_t nvsIndex[NVS_ENTRIES];         // Key hashes of the NVS entries, oldest first. Stored in NVS as "index".
+    byte nvsCount = 0;
+
+    Entry* Find(const MFRC522::Uid& uid);
+    Entry* Put(const MFRC522::Uid& uid, const String& uri, uint32_t checksum);  // Replaces the least recently used entry
+    void Track(uint32_t hash);                                                  // Adds a key to the index, evicting the oldest if full
+    void Untrack(uint32_t hash);
+    void SaveIndex();
+    static uint32_t KeyHash(const MFRC522::Uid& uid);
+    static String Key(uint32_t hash);                                           // NVS keys are limited to 15 characters
+};
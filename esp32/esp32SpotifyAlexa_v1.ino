@@ -5,7 +5,14 @@
 #include <deque>
 #include <algorithm>      // for std::swap
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include <esp_pm.h>
 #include "MFRC522.h"
+#include "MifareClassic.h"
+#include "UriCache.h"
+#include "GainTuner.h"
+#include "CompactUri.h"
+#include "SpscQueue.h"
 #include "SpotifyClient.h"
 #include "settings.h"     // your ssid, pass, clientId, clientSecret, deviceName, refreshToken
 
@@ -15,8 +22,10 @@ std::deque<String> logHistory;
 
 WiFiServer telnetServer(23);
 WiFiClient telnetClient;
+SemaphoreHandle_t logMutex = xSemaphoreCreateMutex();   // The RFID task logs from the other core
 
 void logMessage(const String& msg) {
+  xSemaphoreTake(logMutex, portMAX_DELAY);
   // push into history
   logHistory.push_back(msg);
   if (logHistory.size() > MAX_LOG_HISTORY) logHistory.pop_front();
@@ -26,13 +35,53 @@ void logMessage(const String& msg) {
   if (telnetClient && telnetClient.connected()) {
     telnetClient.println(msg);
   }
+  xSemaphoreGive(logMutex);
 }
 #define LOG(x) logMessage(x)
 
 // ——— NFC reader ———
 #define RST_PIN 4
 #define SS_PIN  5
+//#define IRQ_PIN 21   // optional, see README
 MFRC522 mfrc522(SS_PIN, RST_PIN);
+Preferences prefs;   // NVS, keeps the calibrated RFID SPI clock across reboots
+UriCache uriCache;   // UID → URI, so known cards play without block reads
+GainTuner gainTuner(mfrc522);   // Receiver gain picked for our card stock and enclosure
+
+// ——— RFID task ———
+// Polling and decoding run on core 0 so a tap is picked up even while loop() waits on HTTP/TLS.
+// Only the RFID task touches mfrc522 and uriCache once setup() has started it.
+#define RFID_TASK_CORE    0
+#define RFID_POLL_MS      20
+#define MAX_CARDS_PER_TAP 4   // Stacked cards read in one pass
+#define RFID_HEALTH_MS    5000  // VersionReg check interval
+#define RFID_SELFTEST_EVERY 60  // Full self-test every n health checks (5 min)
+
+// Low-power detection: uncomment to duty-cycle the RC522. Between sensing bursts it sits in soft power-down
+// with the antenna off and the ESP32 light-sleeps. A longer interval draws less current on average,
+// but a tap can take up to that long to be noticed.
+//#define LOW_POWER_SENSE_MS 250
+#define FIELD_SETTLE_MS   5   // Cards need a few ms in the field to power up before they answer REQA
+
+// Register tracing: build with MFRC522_ENABLE_TRACE=1 and send "trace" over telnet to get the register
+// accesses of the last tap, for trace_phases.py. Polls without a card are not kept.
+#if MFRC522_ENABLE_TRACE
+MFRC522Trace rfidTrace;
+volatile bool traceDumpRequested = false;   // Set by loop(), served by the RFID task that owns the trace
+bool traceFrozen = false;                   // Holds a tap, recording stops until it was dumped
+#endif
+
+// Gain calibration: uncomment, flash, and hold a typical card in its case on the reader after boot.
+// Every receiver gain is tried and the best one is stored in NVS, so comment it out again afterwards.
+//#define CALIBRATE_GAIN
+
+struct TapEvent {
+  char uri[128];
+  bool queued;        // A further card of a stack: add to the queue instead of playing
+};
+SpscQueue<TapEvent, 8> tapQueue;   // RFID task → loop()
+TaskHandle_t loopTask = nullptr;   // Notified by queueTap(), so loop() can sleep until a tap arrives
+#define LOOP_IDLE_MS 50            // Longest loop() sleep, for telnet and Wi-Fi checks
 
 // ——— Spotify client ———
 SpotifyClient spotify(clientId, clientSecret, deviceName, refreshToken);
@@ -48,9 +97,21 @@ void handleTelnet();
 void connectWifi();
 void ensureWifiConnected();
 void logError(const String& msg, int code);
-void readNFCTag();
+void setupRfidClock();
+void rfidTask(void* param);
+bool checkReaderHealth();
+void calibrateGain();
+void serviceTrace();
+byte readCardsInField(MFRC522::Uid* found, const MFRC522::Uid* skip, byte skipCount);
+void senseBurst();
+void setupLowPower();
+void queueTap(const String& uri, bool queued);
+void readNFCTag(bool queued);
 String readFromCard();
-MFRC522::StatusCode authenticateBlock(byte block, MFRC522::MIFARE_Key* key);
+int readCardHeader(MifareClassic& card, uint32_t& checksum);
+bool cardMatchesCache(uint32_t checksum);
+void playUri(const String& uri);
+void queueUri(const String& uri);
 void playSpotifyUri(const String& uri);
 void disableShuffle();
 void playRandomAlbumFromArtist(const String& artistUri);
@@ -58,6 +119,7 @@ void playRandomAlbumFromArtist(const String& artistUri);
 void setup() {
   Serial.begin(115200);
   LOG("[Main] Setup started");
+  loopTask = xTaskGetCurrentTaskHandle();
 
   connectWifi();
   telnetServer.begin();
@@ -66,7 +128,25 @@ void setup() {
 
   SPI.begin();
   mfrc522.PCD_Init();
+  setupRfidClock();
+  if (gainTuner.Begin()) {
+    LOG("[RFID] Using stored gain 0x" + String(gainTuner.GetGain(), HEX));
+  }
+  if (!uriCache.Begin()) {
+    LOG("[Main] NVS not available, caching card URIs in RAM only");
+  }
+#if MFRC522_ENABLE_TRACE
+  mfrc522.PCD_SetTrace(&rfidTrace);
+#endif
+#ifdef IRQ_PIN
+  mfrc522.PCD_EnableIrq(IRQ_PIN);
+  LOG("[Main] MFRC522 IRQ mode on pin " + String(IRQ_PIN));
+#endif
   LOG("[Main] MFRC522 ready");
+#ifdef LOW_POWER_SENSE_MS
+  setupLowPower();
+#endif
+  xTaskCreatePinnedToCore(rfidTask, "rfid", 6144, nullptr, 1, nullptr, RFID_TASK_CORE);
 
   // Prime Spotify token & deviceId
   if (!spotify.EnsureTokenFresh()) {
@@ -89,31 +169,61 @@ void loop() {
     wasDisconnected = false;
   }
 
-  // Every time a tag is present, read & play
-  if (mfrc522.PICC_IsNewCardPresent()) {
-    LOG("[Main] NFC tag detected");
-    readNFCTag();
+  // Play whatever the RFID task decoded
+  TapEvent tap;
+  while (tapQueue.Pop(tap)) {
+    if (tap.queued) {
+      queueUri(String(tap.uri));
+    } else {
+      playUri(String(tap.uri));
+    }
   }
+
+  // Block instead of spinning, so the cores can idle (and light-sleep, see LOW_POWER_SENSE_MS).
+  // A tap pushed after the loop above leaves a notification behind, and this returns right away.
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOOP_IDLE_MS));
 }
 
 // ——— Telnet & Wi-Fi helpers ———
 
 void handleTelnet() {
+  // The RFID task writes to telnetClient from the other core, so every use of it holds logMutex
   if (telnetServer.hasClient()) {
-    if (!telnetClient || !telnetClient.connected()) {
+    xSemaphoreTake(logMutex, portMAX_DELAY);
+    bool idle = !telnetClient || !telnetClient.connected();
+    if (idle) {
       telnetClient = telnetServer.available();
       telnetClient.flush();
       // replay history
       for (auto &line : logHistory) {
         telnetClient.println(line);
       }
-      LOG("[Telnet] New client connected");
     } else {
       WiFiClient busy = telnetServer.available();
       busy.println("Busy – one client only");
       busy.stop();
     }
+    xSemaphoreGive(logMutex);
+    if (idle) LOG("[Telnet] New client connected");
+  }
+#if MFRC522_ENABLE_TRACE
+  // Only the bytes that have arrived are read, so a partial line never blocks loop()
+  static char command[8];
+  static byte commandLength = 0;
+  xSemaphoreTake(logMutex, portMAX_DELAY);
+  int pending = (telnetClient && telnetClient.connected()) ? telnetClient.available() : 0;
+  while (pending-- > 0) {
+    int c = telnetClient.read();
+    if (c < 0 || c == '\r') continue;
+    if (c != '\n') {
+      if (commandLength < sizeof(command)) command[commandLength++] = c;   // Longer lines cannot match anyway
+      continue;
+    }
+    if (commandLength == 5 && memcmp(command, "trace", 5) == 0) traceDumpRequested = true;
+    commandLength = 0;
   }
+  xSemaphoreGive(logMutex);
+#endif
 }
 
 void connectWifi() {
@@ -147,74 +257,344 @@ void logError(const String& msg, int code) {
   LOG("[Error] " + msg + " (HTTP " + String(code) + ")");
 }
 
-// ——— NFC tag & card reading ———
-
-void readNFCTag() {
-  if (!mfrc522.PICC_ReadCardSerial()) {
-    LOG("[Main] Failed to read card serial");
-    return;
+// ——— RFID SPI clock ———
+
+// Use the SPI clock stored in NVS if it still passes the FIFO loopback,
+// otherwise step it up to the fastest clock the wiring handles and store that.
+void setupRfidClock() {
+  prefs.begin("rfid", false);
+  uint32_t clock = prefs.getUInt("spiclk", 0);
+  if (clock) {
+    mfrc522.PCD_SetSPIClock(clock);
+    if (mfrc522.PCD_PerformFIFOLoopbackTest()) {
+      LOG("[Main] RFID SPI clock " + String(clock) + " Hz (stored)");
+      prefs.end();
+      return;
+    }
+    LOG("[Main] Stored RFID SPI clock failed loopback → recalibrating");
+  }
+  clock = mfrc522.PCD_CalibrateSPIClock();
+  if (clock) {
+    prefs.putUInt("spiclk", clock);
+    LOG("[Main] RFID SPI clock calibrated to " + String(clock) + " Hz");
+  } else {
+    LOG("[Main] RFID SPI calibration failed, is the MFRC522 connected?");
   }
+  prefs.end();
+}
 
-  String uri = readFromCard();
-  LOG("[Main] Card URI: " + uri);
+// ——— NFC tag & card reading (RFID task) ———
+
+void rfidTask(void* param) {
+#ifdef CALIBRATE_GAIN
+  calibrateGain();
+#endif
+  for (;;) {
+#if MFRC522_ENABLE_TRACE
+    serviceTrace();
+#endif
+#ifdef LOW_POWER_SENSE_MS
+    senseBurst();
+    vTaskDelay(pdMS_TO_TICKS(LOW_POWER_SENSE_MS));
+#else
+    // Every time a tag is present, read & queue it. Halted cards ignore REQA, so a card
+    // resting on the reader is not read again. A self-test or reset switches the field off, which
+    // takes resting cards out of HALT; on the poll after it the cards read last are skipped instead.
+    static MFRC522::Uid resting[MAX_CARDS_PER_TAP];
+    static byte restingCount = 0;
+    bool fieldReset = checkReaderHealth();
+    if (fieldReset) vTaskDelay(pdMS_TO_TICKS(FIELD_SETTLE_MS));
+    if (mfrc522.PICC_IsNewCardPresent()) {
+      MFRC522::Uid found[MAX_CARDS_PER_TAP];
+      byte count = readCardsInField(found, resting, fieldReset ? restingCount : 0);
+      memcpy(resting, found, count * sizeof(MFRC522::Uid));
+      restingCount = count;
+    }
+    vTaskDelay(pdMS_TO_TICKS(RFID_POLL_MS));
+#endif
+  }
+}
 
-  // Clean up
-  mfrc522.PICC_HaltA();
-  mfrc522.PCD_StopCrypto1();
+// Reads VersionReg every RFID_HEALTH_MS, and right away after a command the chip never finished.
+// A reader that stopped answering is reset instead of being polled forever. chipTimeouts only counts
+// commands that ran past their wall-clock limit, so a fast SPI clock does not trigger false resets.
+// Returns true if the field was switched off (self-test or reset), so halted cards are awake again.
+bool checkReaderHealth() {
+  static uint32_t lastCheck = 0;
+  static uint32_t lastChipTimeouts = 0;
+  static uint16_t checks = 0;
+  const MFRC522::PCD_ErrorCounters& e = mfrc522.PCD_GetErrorCounters();
+  uint32_t elapsed = millis() - lastCheck;
+  if (elapsed < RFID_HEALTH_MS && (e.chipTimeouts == lastChipTimeouts || elapsed < 1000)) return false;
+  lastCheck = millis();
+
+  bool selfTest = (++checks % RFID_SELFTEST_EVERY) == 0;
+  bool healthy = mfrc522.PCD_CheckHealth(selfTest);
+  if (!healthy) {
+    LOG("[RFID] Reader not responding, reset it (" + String(e.recoveries) + " resets so far)");
+  }
+  if (!healthy || selfTest) gainTuner.Apply();   // Both may have reset RFCfgReg
+  lastChipTimeouts = e.chipTimeouts;
+  if (selfTest) {
+    LOG("[RFID] Errors: " + String(e.chipTimeouts) + " chip timeouts, " + String(e.crcErrors) + " CRC, " +
+        String(e.collisions) + " collisions, " + String(e.nacks) + " NACKs, " + String(e.errors) + " other, " +
+        String(e.timeouts) + " PICC timeouts");
+  }
+  return !healthy || selfTest;
+}
 
-  if (uri.startsWith("spotify:artist:")) {
-    playRandomAlbumFromArtist(uri);
-  } else if (uri.startsWith("spotify:")) {
-    playSpotifyUri(uri);
-  } else {
-    LOG("[Main] Unknown URI format");
+#if MFRC522_ENABLE_TRACE
+// Dumps the trace to the telnet client when asked, and starts recording again. Until then a held tap
+// stays frozen, while the trace of an empty poll is dropped so the next tap starts with an empty buffer.
+void serviceTrace() {
+  if (traceDumpRequested) {
+    xSemaphoreTake(logMutex, portMAX_DELAY);
+    if (telnetClient && telnetClient.connected()) rfidTrace.Dump(telnetClient);
+    xSemaphoreGive(logMutex);
+    traceDumpRequested = false;
+    traceFrozen = false;
+    rfidTrace.Clear();
+    mfrc522.PCD_SetTrace(&rfidTrace);
+  } else if (!traceFrozen) {
+    rfidTrace.Clear();
   }
 }
+#endif
 
-String readFromCard() {
+// Waits for a card and sweeps the receiver gain against it. Runs once, before the first poll.
+void calibrateGain() {
+  LOG("[RFID] Gain calibration: hold a card on the reader");
+  while (!mfrc522.PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) {
+    vTaskDelay(pdMS_TO_TICKS(RFID_POLL_MS));
+  }
   MFRC522::MIFARE_Key key;
   for (byte i = 0; i < 6; i++) key.keyByte[i] = 0xFF;
+  bool calibrated = gainTuner.Calibrate(key);
+  String trials = "/" + String(gainTuner.GetTrials());
+  for (byte i = 0; i < GainTuner::GAIN_COUNT; i++) {
+    const GainTuner::Result& r = gainTuner.GetResult(i);
+    LOG("[RFID] Gain 0x" + String(r.gain, HEX) + ": " + String(r.successes) + trials + " first-try reads, mean " +
+        String(r.meanMicros) + " us");
+  }
+  if (calibrated) {
+    const GainTuner::Result& best = gainTuner.GetBest();
+    LOG("[RFID] Gain calibrated to 0x" + String(gainTuner.GetGain(), HEX) + " (" + String(best.successes) + trials +
+        ", " + String(best.meanMicros) + " us), remove the card");
+  } else {
+    LOG("[RFID] Gain calibration failed, is the card readable at all?");
+  }
+}
+
+// Selects every card in the field, so stacked cards are read one after the other instead of colliding.
+// Cards listed in skip are left alone. Returns the number of cards found, all of them stored in found.
+byte readCardsInField(MFRC522::Uid* found, const MFRC522::Uid* skip, byte skipCount) {
+  byte count = mfrc522.PICC_SelectAll(found, MAX_CARDS_PER_TAP);
+  bool first = true;
+  for (byte i = 0; i < count; i++) {
+    bool resting = false;
+    for (byte j = 0; j < skipCount && !resting; j++) {
+      resting = skip[j].size == found[i].size && memcmp(skip[j].uidByte, found[i].uidByte, found[i].size) == 0;
+    }
+    if (resting) continue;
+
+    LOG("[RFID] NFC tag detected (" + String(i + 1) + " of " + String(count) + ")");
+    if (mfrc522.PICC_WakeupAndSelect(&found[i]) != MFRC522::STATUS_OK) {
+      LOG("[RFID] Failed to select card " + String(i + 1) + " of " + String(count));
+      continue;
+    }
+    readNFCTag(!first);
+    first = false;
+  }
+#if MFRC522_ENABLE_TRACE
+  if (!first) {
+    mfrc522.PCD_SetTrace(nullptr);   // Keep this tap for the "trace" telnet command
+    traceFrozen = true;
+  }
+#endif
+  return count;
+}
+
+// One low-power sensing burst. Switching the field off resets every card, so a card resting on the
+// reader answers REQA again on the next burst; the UIDs seen last time are skipped instead.
+void senseBurst() {
+  static MFRC522::Uid resting[MAX_CARDS_PER_TAP];
+  static byte restingCount = 0;
+
+  mfrc522.PCD_SoftPowerUp();     // Registers survive soft power-down, only the oscillator has to restart
+  mfrc522.PCD_AntennaOn();
+  checkReaderHealth();           // Resets turn the antenna on again, so check before sensing
+  vTaskDelay(pdMS_TO_TICKS(FIELD_SETTLE_MS));
 
-  String result;
-  byte block = 4;
-  bool gotData = false;
+  MFRC522::Uid found[MAX_CARDS_PER_TAP];
+  byte count = 0;
+  if (mfrc522.PICC_IsNewCardPresent()) {
+    count = readCardsInField(found, resting, restingCount);
+  }
+  memcpy(resting, found, count * sizeof(MFRC522::Uid));
+  restingCount = count;
 
-  while (block < 64) {
-    if (block % 4 == 3) { block++; continue; } // skip trailers
+  mfrc522.PCD_AntennaOff();
+  mfrc522.PCD_SoftPowerDown();
+}
 
-    if (authenticateBlock(block, &key) != MFRC522::STATUS_OK) break;
+// Lets the ESP32 light-sleep whenever both cores are idle, e.g. while the RFID task waits between bursts.
+// Wi-Fi stays associated in modem sleep, so playback still starts without reconnecting.
+void setupLowPower() {
+  WiFi.setSleep(true);
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t pm = {};
+#else
+  esp_pm_config_esp32_t pm = {};
+#endif
+  pm.max_freq_mhz = 240;
+  pm.min_freq_mhz = 80;          // Lowest clock Wi-Fi works with
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  pm.light_sleep_enable = true;
+#else
+  LOG("[Main] Tickless idle not enabled in this core build, no automatic light sleep");
+#endif
+  esp_err_t err = esp_pm_configure(&pm);
+  LOG("[Main] Power management " + String(err == ESP_OK ? "on" : "failed") +
+      ", RFID sensing every " + String(LOW_POWER_SENSE_MS) + " ms");
+#else
+  LOG("[Main] Power management not enabled in this core build, only the RC522 is duty-cycled");
+#endif
+}
 
-    byte buffer[18];
-    byte size = sizeof(buffer);
-    if (mfrc522.MIFARE_Read(block, buffer, &size) != MFRC522::STATUS_OK) break;
+void queueTap(const String& uri, bool queued) {
+  TapEvent tap;
+  strlcpy(tap.uri, uri.c_str(), sizeof(tap.uri));
+  tap.queued = queued;
+  if (!tapQueue.Push(tap)) {
+    LOG("[RFID] Tap queue full, dropping " + uri);
+    return;
+  }
+  xTaskNotifyGive(loopTask);
+}
 
-    String chunk;
-    for (byte i = 0; i < 16; i++) {
-      if (buffer[i] != 0) { chunk += (char)buffer[i]; gotData = true; }
+// Reads the selected card. queued is passed on with its URI, see TapEvent.
+void readNFCTag(bool queued) {
+  String uri;
+  uint32_t checksum;
+  if (uriCache.Lookup(mfrc522.uid, uri, checksum)) {
+    // Known card: one header block tells whether it was rewritten since. Only then is the URI queued,
+    // a stale one could not be taken back out of the Spotify queue.
+    if (cardMatchesCache(checksum)) {
+      LOG("[RFID] Card URI (cached): " + uri);
+    } else {
+      LOG("[RFID] Card changed since it was cached → reading it again");
+      uriCache.Remove(mfrc522.uid);
+      uri = readFromCard();
+      LOG("[RFID] Card URI: " + uri);
+    }
+    queueTap(uri, queued);
+  } else {
+    uri = readFromCard();
+    LOG("[RFID] Card URI: " + uri);
+    queueTap(uri, queued);
+  }
+  LOG("[RFID] URI cache: " + String(uriCache.GetHits()) + " hits, " + String(uriCache.GetMisses()) + " misses, " +
+      String(uriCache.GetEvictions()) + " evicted");
+
+  // Clean up
+  mfrc522.PICC_HaltA();
+  mfrc522.PCD_StopCrypto1();
+}
+
+// Reads the URI and caches it if the card's header block vouches for the text
+String readFromCard() {
+  MFRC522::MIFARE_Key key;
+  for (byte i = 0; i < 6; i++) key.keyByte[i] = 0xFF;
+
+  MifareClassic card(mfrc522);
+  card.Begin(key);
+  byte data[256];
+  // Blocks 4 and 5 share sector 1: one authentication covers a compact URI
+  int len = card.Read(4, data, 32);
+  unsigned long readMicros = card.GetLastDurationMicros();
+  if (len < 0) LOG("[RFID] " + card.GetLastError());
+
+  String text;
+  // len is -1 after a failed read, which Decode() would take for SIZE_MAX
+  if (len < (int)CompactUri::SIZE || !CompactUri::Decode(data, len, text)) {
+    // Text card, read on until the end marker
+    if (len == 32) {
+      int more = card.Read(6, data + 32, sizeof(data) - 32);
+      readMicros += card.GetLastDurationMicros();
+      if (more < 0) LOG("[RFID] " + card.GetLastError());
+      len = (more < 0) ? more : 32 + more;
+    }
+    for (int i = 0; i < len; i++) {
+      if (data[i] != 0) text += (char)data[i];
     }
-    if (!gotData) break;
-    result += chunk;
-    block++;
-    gotData = false;
   }
+  LOG("[RFID] Card read: " + String(card.GetAuthCount()) + " auths, " +
+      String(readMicros) + " us");
 
+  String result = text;
   if (!result.startsWith("spotify:")) result = "spotify:" + result;
+
+  uint32_t checksum;
+  if (len > 0 && readCardHeader(card, checksum) == 1 &&
+      checksum == UriCache::Checksum((const byte*)text.c_str(), text.length())) {
+    if (!uriCache.Store(mfrc522.uid, result, checksum)) {
+      LOG("[RFID] Failed to store card URI in NVS");
+    }
+  }
   return result;
 }
 
-MFRC522::StatusCode authenticateBlock(byte block, MFRC522::MIFARE_Key* key) {
-  for (int i = 0; i < 3; i++) {
-    auto st = mfrc522.PCD_Authenticate(
-      MFRC522::PICC_CMD_MF_AUTH_KEY_A,
-      block, key, &mfrc522.uid
-    );
-    if (st == MFRC522::STATUS_OK) return st;
+// Returns 1 and the checksum if the card has a valid header block, 0 if it has none, -1 if it could not be read
+int readCardHeader(MifareClassic& card, uint32_t& checksum) {
+  byte header[16];
+  int len = card.Read(UriCache::HEADER_BLOCK, header, sizeof(header));
+  if (len < 0) {
+    LOG("[RFID] Header: " + card.GetLastError());
+    return -1;
+  }
+  return (len == 16 && UriCache::ParseHeader(header, checksum)) ? 1 : 0;
+}
+
+// False only if the card is still readable and its header no longer matches the cached entry
+bool cardMatchesCache(uint32_t checksum) {
+  MFRC522::MIFARE_Key key;
+  for (byte i = 0; i < 6; i++) key.keyByte[i] = 0xFF;
+
+  MifareClassic card(mfrc522);
+  card.Begin(key);
+  uint32_t current;
+  int result = readCardHeader(card, current);
+  if (result < 0) return true;   // Card already gone, nothing to compare against
+  return result == 1 && current == checksum;
+}
+
+void playUri(const String& uri) {
+  if (uri.startsWith("spotify:artist:")) {
+    playRandomAlbumFromArtist(uri);
+  } else if (uri.startsWith("spotify:")) {
+    playSpotifyUri(uri);
+  } else {
+    LOG("[Main] Unknown URI format");
   }
-  return MFRC522::STATUS_ERROR;
 }
 
 // ——— Spotify playback helpers ———
 
+// Only tracks and episodes can go into the Spotify queue
+void queueUri(const String& uri) {
+  if (!uri.startsWith("spotify:track:") && !uri.startsWith("spotify:episode:")) {
+    LOG("[Main] Cannot queue " + uri + ", only tracks and episodes");
+    return;
+  }
+  int code = spotify.Queue(uri);
+  if (code == 200 || code == 204) {
+    LOG("[Main] Queued " + uri);
+  } else {
+    logError("queueUri", code);
+  }
+}
+
 void playSpotifyUri(const String& uri) {
   LOG("[Main] playSpotifyUri → " + uri);
   disableShuffle();
@@ -0,0 +1,69 @@
+// Minimal Arduino core for running the MFRC522 driver on Linux through MFRC522TransportSpidev.
+// Time is real (CLOCK_MONOTONIC). There is no GPIO: tie RST high and pass MFRC522::UNUSED_PIN, so
+// PCD_Init() does a soft reset. See the README for the build line.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define FALLING 2
+#define MSBFIRST 1
+#define DEC 10
+#define HEX 16
+#define SS 0
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+
+inline uint64_t monotonicMicros() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000u + now.tv_nsec / 1000;
+}
+inline unsigned long micros() { return (unsigned long)monotonicMicros(); }
+inline unsigned long millis() { return (unsigned long)(monotonicMicros() / 1000); }
+inline void delayMicroseconds(unsigned int us) {
+	struct timespec wait = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000 };
+	nanosleep(&wait, nullptr);
+}
+inline void delay(unsigned long ms) {
+	struct timespec wait = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+	nanosleep(&wait, nullptr);
+}
+inline void yield() {}
+
+// No GPIO. NRSTPD reads high, so PCD_Init() does a soft reset, and PCD_EnableIrq() stays in polling mode.
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(int, void (*)(void *), void *, int) {}
+inline void detachInterrupt(int) {}
+
+class Print {
+public:
+	void print(const char *text) { fputs(text, stdout); }
+	void print(const __FlashStringHelper *text) { print(reinterpret_cast<const char *>(text)); }
+	void print(char c) { putchar(c); }
+	void print(unsigned long value, int base = DEC) { printf(base == HEX ? "%lX" : "%lu", value); }
+	void print(long value, int base = DEC) { if (base == HEX) print((unsigned long)value, base); else printf("%ld", value); }
+	void print(unsigned int value, int base = DEC) { print((unsigned long)value, base); }
+	void print(int value, int base = DEC) { print((long)value, base); }
+	void print(unsigned char value, int base = DEC) { print((unsigned long)value, base); }
+	void println() { putchar('\n'); }
+	template <typename T> void println(T value) { print(value); println(); }
+	template <typename T> void println(T value, int base) { print(value, base); println(); }
+};
+extern Print Serial;
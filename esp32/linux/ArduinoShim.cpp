@@ -0,0 +1,6 @@
+// Globals of the Linux Arduino shim
+#include <Arduino.h>
+#include <SPI.h>
+
+Print Serial;
+SPIClass SPI;
@@ -0,0 +1,29 @@
+// Prints the UID of every card put on an RC522 wired to a Linux SPI bus, e.g. on a Raspberry Pi:
+// SDA to CE0, SCK, MOSI, MISO to the SPI0 pins, RST to 3.3V. Enable SPI, then run ./read_uid /dev/spidev0.0
+#include <Arduino.h>
+#include "MFRC522.h"
+#include "MFRC522TransportSpidev.h"
+
+int main(int argc, char **argv) {
+	const char *device = argc > 1 ? argv[1] : "/dev/spidev0.0";
+	MFRC522TransportSpidev bus(device, 4000000u);
+	MFRC522 mfrc522(bus);
+	mfrc522.PCD_Init();
+	if (!bus.IsOpen()) {
+		fprintf(stderr, "Cannot open %s\n", device);
+		return 1;
+	}
+	mfrc522.PCD_DumpVersionToSerial();
+
+	for (;;) {
+		if (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial()) {
+			printf("Card UID:");
+			for (byte i = 0; i < mfrc522.uid.size; i++) {
+				printf(" %02X", mfrc522.uid.uidByte[i]);
+			}
+			printf(", %s\n", reinterpret_cast<const char *>(MFRC522::PICC_GetTypeName(MFRC522::PICC_GetType(mfrc522.uid.sak))));
+			mfrc522.PICC_HaltA();
+		}
+		delay(50);
+	}
+}
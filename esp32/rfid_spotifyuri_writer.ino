@@ -1,5 +1,8 @@
 #include <SPI.h>
-#include <MFRC522.h>
+#include "MFRC522.h"
+#include "MifareClassic.h"
+#include "UriCache.h"
+#include "CompactUri.h"
 
 #define RST_PIN 4  // Reset pin
 #define SS_PIN 5   // Slave select pin
@@ -75,15 +78,6 @@ void handleSerialInput() {
   inputBuffer = "";
 }
 
-MFRC522::StatusCode authenticateBlock(byte block, MFRC522::MIFARE_Key *key) {
-  MFRC522::StatusCode status;
-  for (int retries = 0; retries < 3; retries++) { // Retry up to 3 times
-    status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key, &(mfrc522.uid));
-    if (status == MFRC522::STATUS_OK) break;
-  }
-  return status;
-}
-
 void checkCardPresence() {
   static unsigned long cardDetectedTime = 0; // Last time a card was detected
   static unsigned long cardRemovedTime = 0; // Last time a card was removed
@@ -117,38 +111,38 @@ bool writeToCard(String data) {
     key.keyByte[i] = 0xFF; // Default key
   }
 
-  byte block = 4;  // Start block for writing
-  int length = data.length();
-  byte buffer[16];
-
-  for (int i = 0; i < length; i += 16) {
-    int chunkSize = (length - i > 16) ? 16 : (length - i);
-    for (int j = 0; j < 16; j++) {
-      buffer[j] = (j < chunkSize) ? data[i + j] : 0; // Pad with zeros
-    }
-
-    if (authenticateBlock(block, &key) != MFRC522::STATUS_OK) {
-      Serial.print("Authentication failed at block ");
-      Serial.println(block);
-      return false;
-    }
-
-    if (mfrc522.MIFARE_Write(block, buffer, 16) != MFRC522::STATUS_OK) {
-      Serial.print("Write failed at block ");
-      Serial.println(block);
-      return false;
-    }
-
-    Serial.print("Data written to block ");
-    Serial.println(block);
+  // Start at block 4, the sector trailers are skipped by MifareClassic
+  MifareClassic card(mfrc522);
+  card.Begin(key);
+  // Spotify URIs go in compact form when possible: 19 bytes in blocks 4 and 5 instead of 28+ bytes of text.
+  // It is written as 32 bytes, so Write() also puts an end marker in block 6 for older readers.
+  byte compact[32] = {0};
+  bool ok;
+  if (CompactUri::Encode(data, compact)) {
+    Serial.println("Writing compact URI");
+    ok = card.Write(4, compact, sizeof(compact));
+  } else {
+    Serial.println("No compact form for this URI, writing text");
+    ok = card.Write(4, (const byte*)data.c_str(), data.length());
+  }
 
-    block++;
-    if (block == 7 || block == 11) {
-      block++; // Skip trailer blocks
-    }
+  // Header block with a checksum of the text, so readers can tell a cached copy is stale.
+  // Write() also clears block 2 as the end marker.
+  if (ok) {
+    byte header[16];
+    UriCache::BuildHeader(data, header);
+    ok = card.Write(UriCache::HEADER_BLOCK, header, sizeof(header));
+  }
+  if (!ok) {
+    Serial.println(card.GetLastError());
   }
 
-  return true;
+  Serial.print("Write took ");
+  Serial.print(card.GetLastDurationMicros());
+  Serial.print(" us with ");
+  Serial.print(card.GetAuthCount());
+  Serial.println(" authentications");
+  return ok;
 }
 
 String readFromCard() {
@@ -157,51 +151,31 @@ String readFromCard() {
     key.keyByte[i] = 0xFF; // Default key
   }
 
-  byte block = 4;  // Start block for reading
-  String result = "";
-  byte buffer[18];
-  byte size = sizeof(buffer);
-  bool hasData = false; // Flag to check if meaningful data is found
-
-  while (block < 64) {  // Loop through data blocks
-    if (block == 7 || block == 11) {
-      block++; // Skip trailer blocks
-      continue;
-    }
-
-    if (authenticateBlock(block, &key) != MFRC522::STATUS_OK) {
-      Serial.print("Authentication failed at block ");
-      Serial.println(block);
-      break;
-    }
-
-    if (mfrc522.MIFARE_Read(block, buffer, &size) != MFRC522::STATUS_OK) {
-      Serial.print("Read failed at block ");
-      Serial.println(block);
-      break;
-    }
+  MifareClassic card(mfrc522);
+  card.Begin(key);
+  byte data[256];
+  int length = card.Read(4, data, sizeof(data));
+  if (length < 0) {
+    Serial.println(card.GetLastError());
+  }
 
-    // Check for non-zero data
-    for (byte i = 0; i < 16; i++) {
-      if (buffer[i] != 0) {
-        hasData = true;
-        result += (char)buffer[i]; // Append valid characters
+  String result = "";
+  if (length < (int)CompactUri::SIZE || !CompactUri::Decode(data, length, result)) {   // length is -1 after a failed read
+    for (int i = 0; i < length; i++) {
+      if (data[i] != 0) {
+        result += (char)data[i]; // Append valid characters
       }
     }
-
-    // Stop reading if no meaningful data is found
-    if (!hasData) {
-      break;
-    }
-
-    hasData = false; // Reset flag for next block
-    block++;
   }
 
+  Serial.print("Read took ");
+  Serial.print(card.GetLastDurationMicros());
+  Serial.print(" us with ");
+  Serial.print(card.GetAuthCount());
+  Serial.println(" authentications");
   return result;
 }
 
-
 void printCardDetails() {
   Serial.print("Card UID: ");
   for (byte i = 0; i < mfrc522.uid.size; i++) {
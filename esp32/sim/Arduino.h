@@ -0,0 +1,58 @@
+// Minimal Arduino core for building the MFRC522 driver on a Linux host against RC522Sim.
+// Time is virtual: delay() and the simulated chip advance it, nothing ever sleeps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define FALLING 2
+#define MSBFIRST 1
+#define DEC 10
+#define HEX 16
+#define SS 5
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper *>(text))
+
+// Virtual clock, in microseconds since start
+extern uint64_t simMicros;
+inline unsigned long micros() { return (unsigned long)simMicros; }
+inline unsigned long millis() { return (unsigned long)(simMicros / 1000); }
+inline void delay(unsigned long ms) { simMicros += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { simMicros += us; }
+inline void yield() { simMicros += 1; }
+
+// There is no GPIO. NRSTPD reads high, so PCD_Init() does a soft reset.
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterruptArg(int, void (*)(void *), void *, int) {}
+inline void detachInterrupt(int) {}
+
+class Print {
+public:
+	void print(const char *text) { fputs(text, stdout); }
+	void print(const __FlashStringHelper *text) { print(reinterpret_cast<const char *>(text)); }
+	void print(char c) { putchar(c); }
+	void print(unsigned long value, int base = DEC) { printf(base == HEX ? "%lX" : "%lu", value); }
+	void print(long value, int base = DEC) { if (base == HEX) print((unsigned long)value, base); else printf("%ld", value); }
+	void print(unsigned int value, int base = DEC) { print((unsigned long)value, base); }
+	void print(int value, int base = DEC) { print((long)value, base); }
+	void print(unsigned char value, int base = DEC) { print((unsigned long)value, base); }
+	void println() { putchar('\n'); }
+	template <typename T> void println(T value) { print(value); println(); }
+	template <typename T> void println(T value, int base) { print(value, base); println(); }
+};
+extern Print Serial;
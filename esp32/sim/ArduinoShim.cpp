@@ -0,0 +1,7 @@
+// Globals of the host Arduino shim
+#include <Arduino.h>
+#include <SPI.h>
+
+uint64_t simMicros = 0;
+Print Serial;
+SPIClass SPI;
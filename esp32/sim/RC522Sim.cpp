@@ -0,0 +1,394 @@
+#include "RC522Sim.h"
+#include <string.h>
+#include "MFRC522.h"
+
+// Register addresses as used inside the chip, ie without the SPI shift
+#define REG(name) (MFRC522::name >> 1)
+
+RC522Sim::RC522Sim() {
+	Reset();
+}
+
+void RC522Sim::Reset() {
+	memset(regs, 0, sizeof(regs));
+	regs[REG(CommandReg)] = 0x20;
+	regs[REG(ComIEnReg)] = 0x80;
+	regs[REG(ComIrqReg)] = 0x14;
+	regs[REG(Status1Reg)] = 0x21;
+	regs[REG(WaterLevelReg)] = 0x08;
+	regs[REG(ControlReg)] = 0x10;
+	regs[REG(CollReg)] = 0xA0;
+	regs[REG(ModeReg)] = 0x3F;
+	regs[REG(TxControlReg)] = 0x80;
+	regs[REG(TxSelReg)] = 0x10;
+	regs[REG(RxSelReg)] = 0x84;
+	regs[REG(RxThresholdReg)] = 0x84;
+	regs[REG(DemodReg)] = 0x4D;
+	regs[REG(MfTxReg)] = 0x62;
+	regs[REG(SerialSpeedReg)] = 0xEB;
+	regs[REG(CRCResultRegH)] = 0xFF;
+	regs[REG(CRCResultRegL)] = 0xFF;
+	regs[REG(ModWidthReg)] = 0x26;
+	regs[REG(RFCfgReg)] = 0x48;
+	regs[REG(GsNReg)] = 0x88;
+	regs[REG(CWGsPReg)] = 0x20;
+	regs[REG(ModGsPReg)] = 0x20;
+	regs[REG(VersionReg)] = 0x92;		// MFRC522 version 2.0
+	fifoLength = 0;
+	memset(internalBuffer, 0, sizeof(internalBuffer));
+	fieldOn = true;						// So that UpdateField() switches it off
+	UpdateField();
+}
+
+bool RC522Sim::AddCard(SimCard *card) {
+	for (uint8_t i = 0; i < MAX_CARDS; i++) {
+		if (cards[i] == nullptr) {
+			cards[i] = card;
+			card->FieldOff();			// Powers up in IDLE
+			return true;
+		}
+	}
+	return false;
+}
+
+void RC522Sim::RemoveCard(SimCard *card) {
+	for (uint8_t i = 0; i < MAX_CARDS; i++) {
+		if (cards[i] == card) {
+			cards[i] = nullptr;
+			card->FieldOff();
+		}
+	}
+}
+
+// ——— Bus ———
+
+void RC522Sim::BusTime(uint8_t count) {
+	// Address byte plus data at the SPI clock, and about 1µs of chip select and driver overhead
+	uint64_t micros = ((uint64_t)(count + 1) * 8 * 1000000 + clock - 1) / clock + 1;
+	stats.transactions++;
+	stats.bytes += count + 1;
+	stats.busMicros += micros;
+	simMicros += micros;
+}
+
+void RC522Sim::WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) {
+	BusTime(count);
+	stats.registerWrites++;
+	for (uint8_t i = 0; i < count; i++) {
+		Write((reg >> 1) & 0x3F, values[i]);
+	}
+}
+
+void RC522Sim::ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) {
+	BusTime(count);
+	stats.registerReads++;
+	for (uint8_t i = 0; i < count; i++) {
+		values[i] = Read((reg >> 1) & 0x3F);
+	}
+}
+
+void RC522Sim::WriteFrames(uint8_t *frames, uint8_t length) {
+	uint8_t index = 0;
+	while (index < length) {
+		uint8_t frameLength = frames[index++];
+		WriteRegister(frames[index], frameLength - 1, &frames[index + 1]);
+		index += frameLength;
+	}
+}
+
+// ——— Registers ———
+
+uint8_t RC522Sim::Read(uint8_t address) {
+	switch (address) {
+		case REG(FIFODataReg): {
+			if (fifoLength == 0) {
+				return 0;
+			}
+			uint8_t value = fifo[0];
+			memmove(fifo, &fifo[1], --fifoLength);
+			return value;
+		}
+		case REG(FIFOLevelReg):
+			return fifoLength;
+		case REG(ComIrqReg):
+			if (timerIrqAt && simMicros >= timerIrqAt) {
+				regs[address] |= 0x01;				// TimerIRq
+				timerIrqAt = 0;
+			}
+			return regs[address];
+		case REG(Status1Reg):
+			// CRCOk, CRCReady, HiAlert and LoAlert follow the FIFO
+			return (regs[address] & ~0x03) | (fifoLength <= regs[REG(WaterLevelReg)] ? 0x01 : 0x00)
+				| (64 - fifoLength <= regs[REG(WaterLevelReg)] ? 0x02 : 0x00);
+		default:
+			return regs[address];
+	}
+}
+
+void RC522Sim::Write(uint8_t address, uint8_t value) {
+	switch (address) {
+		case REG(CommandReg):
+			timerIrqAt = 0;							// A new command stops the timer
+			regs[address] = (regs[address] & 0x0F) | (value & 0x30);
+			if ((value & 0x0F) != MFRC522::PCD_NoCmdChange) {
+				Execute(value & 0x0F);
+			}
+			UpdateField();
+			break;
+		case REG(ComIrqReg):
+		case REG(DivIrqReg):
+			// Set1/Set2: the other bits select which request bits are set (1) or cleared (0)
+			if (value & 0x80) {
+				regs[address] |= value & 0x7F;
+			}
+			else {
+				regs[address] &= ~value;
+			}
+			break;
+		case REG(FIFODataReg):
+			if (fifoLength < sizeof(fifo)) {
+				fifo[fifoLength++] = value;
+			}
+			else {
+				regs[REG(ErrorReg)] |= 0x10;		// BufferOvfl
+			}
+			break;
+		case REG(FIFOLevelReg):
+			if (value & 0x80) {						// FlushBuffer
+				fifoLength = 0;
+				regs[REG(ErrorReg)] &= ~0x10;
+			}
+			break;
+		case REG(Status2Reg):
+			// Only MFCrypto1On (can only be cleared) and the I2C settings are writable
+			regs[address] = (regs[address] & ~0xC8) | (value & 0xC0) | (regs[address] & value & 0x08);
+			break;
+		case REG(BitFramingReg):
+			regs[address] = value & 0x7F;
+			if ((value & 0x80) && (regs[REG(CommandReg)] & 0x0F) == MFRC522::PCD_Transceive) {
+				Transceive();
+			}
+			break;
+		case REG(ErrorReg):
+		case REG(Status1Reg):
+		case REG(VersionReg):
+			break;									// Read only
+		case REG(TxControlReg):
+			regs[address] = value;
+			UpdateField();
+			break;
+		default:
+			regs[address] = value;
+			break;
+	}
+}
+
+void RC522Sim::UpdateField() {
+	bool on = (regs[REG(TxControlReg)] & 0x03) && !(regs[REG(CommandReg)] & 0x10);
+	if (fieldOn && !on) {
+		for (uint8_t i = 0; i < MAX_CARDS; i++) {
+			if (cards[i]) {
+				cards[i]->FieldOff();
+			}
+		}
+		regs[REG(Status2Reg)] &= ~0x08;			// Nothing to be encrypted with any more
+	}
+	fieldOn = on;
+}
+
+// ——— Commands ———
+
+void RC522Sim::Execute(uint8_t command) {
+	regs[REG(CommandReg)] = (regs[REG(CommandReg)] & 0x30) | command;
+	switch (command) {
+		case MFRC522::PCD_SoftReset:
+			Reset();
+			regs[REG(CommandReg)] = 0x20;			// Back in Idle, powered up
+			return;
+		case MFRC522::PCD_Mem:
+			if (fifoLength >= sizeof(internalBuffer)) {
+				memcpy(internalBuffer, fifo, sizeof(internalBuffer));
+				memmove(fifo, &fifo[sizeof(internalBuffer)], fifoLength - sizeof(internalBuffer));
+				fifoLength -= sizeof(internalBuffer);
+			}
+			else {
+				memcpy(internalBuffer, fifo, fifoLength);
+				fifoLength = 0;
+			}
+			break;
+		case MFRC522::PCD_CalcCRC:
+			if (regs[REG(AutoTestReg)] == 0x09) {
+				// Digital self-test: 64 bytes of a fixed pattern, as documented for version 2.0
+				memcpy(fifo, MFRC522_firmware_referenceV2_0, 64);
+				fifoLength = 64;
+			}
+			else {
+				uint8_t crc[2];
+				SimCard::Crc(fifo, fifoLength, crc);
+				fifoLength = 0;
+				regs[REG(CRCResultRegL)] = crc[0];
+				regs[REG(CRCResultRegH)] = crc[1];
+				regs[REG(DivIrqReg)] |= 0x04;		// CRCIRq
+				simMicros += 1;
+			}
+			return;									// Keeps running until the next command
+		case MFRC522::PCD_GenerateRandomID:
+			for (uint8_t i = 0; i < 10; i++) {
+				internalBuffer[i] = (uint8_t)(simMicros * 31 + i * 97);
+			}
+			break;
+		case MFRC522::PCD_MFAuthent:
+			regs[REG(ErrorReg)] = 0;
+			Authenticate();
+			return;
+		case MFRC522::PCD_Transceive:
+		case MFRC522::PCD_Receive:
+		case MFRC522::PCD_Transmit:
+			regs[REG(ErrorReg)] = 0;
+			return;									// Waits for StartSend
+		default:
+			return;									// Idle
+	}
+	regs[REG(CommandReg)] &= 0x30;					// Done, back to Idle
+	regs[REG(ComIrqReg)] |= 0x10;					// IdleIRq
+}
+
+void RC522Sim::Authenticate() {
+	// FIFO: command, block address, 6 key bytes, the first 4 UID bytes
+	SimCard *target = nullptr;
+	if (fieldOn && fifoLength >= 12) {
+		for (uint8_t i = 0; i < MAX_CARDS; i++) {
+			if (cards[i] && memcmp(cards[i]->Uid() + cards[i]->UidSize() - 4, &fifo[8], 4) == 0) {
+				target = cards[i];
+			}
+		}
+	}
+	// Two frames and two answers of the three pass authentication
+	uint64_t air = 2 * ((4 + 2) * 9 * 9.44 + 86) + 2 * (4 * 9 * 9.44 + 86);
+	stats.frames += 2;
+	stats.airMicros += air;
+	simMicros += air;
+	if (target && target->Authenticate(fifo[0], fifo[1], &fifo[2])) {
+		regs[REG(Status2Reg)] |= 0x08;				// MFCrypto1On
+		regs[REG(CommandReg)] &= 0x30;
+		regs[REG(ComIrqReg)] |= 0x10;				// IdleIRq
+	}
+	else {
+		stats.timeouts++;
+		StartTimer();
+	}
+	fifoLength = 0;
+}
+
+// Nobody answered: TimerIRq follows after the timer period, see Read()
+void RC522Sim::StartTimer() {
+	timerIrqAt = simMicros + TimerMicros();
+}
+
+uint64_t RC522Sim::TimerMicros() const {
+	uint32_t prescaler = ((regs[REG(TModeReg)] & 0x0F) << 8) | regs[REG(TPrescalerReg)];
+	uint32_t reload = (regs[REG(TReloadRegH)] << 8) | regs[REG(TReloadRegL)];
+	return (uint64_t)(2 * prescaler + 1) * (reload + 1) * 1000000 / 13560000;
+}
+
+static bool GetBit(const uint8_t *data, size_t i) { return (data[i / 8] >> (i % 8)) & 1; }
+
+void RC522Sim::Transceive() {
+	const uint8_t txLastBits = regs[REG(BitFramingReg)] & 0x07;
+	const uint8_t rxAlign = (regs[REG(BitFramingReg)] >> 4) & 0x07;
+	const double bitMicros = 9.44 / (1 << ((regs[REG(TxModeReg)] >> 4) & 0x07));
+
+	SimFrame in;
+	in.Set(fifo, fifoLength, (regs[REG(TxModeReg)] & 0x80) && txLastBits == 0);
+	if (txLastBits) {
+		in.bits = (fifoLength - 1) * 8 + txLastBits;
+	}
+	fifoLength = 0;
+	regs[REG(ErrorReg)] = 0;
+	regs[REG(ComIrqReg)] |= 0x40;					// TxIRq
+	stats.frames++;
+	uint64_t air = (uint64_t)(in.bits + in.bits / 8 + 2) * bitMicros;
+	simMicros += air;
+	stats.airMicros += air;
+
+	// Every card hears the frame. Their answers overlap on the air.
+	const bool crypto1 = regs[REG(Status2Reg)] & 0x08;
+	SimFrame answers[MAX_CARDS];
+	uint8_t answerCount = 0;
+	for (uint8_t i = 0; i < MAX_CARDS && fieldOn; i++) {
+		if (cards[i] && cards[i]->Receive(in, crypto1, answers[answerCount])) {
+			answerCount++;
+		}
+	}
+	if (answerCount == 0) {
+		stats.timeouts++;
+		StartTimer();
+		return;
+	}
+
+	// Merge: bits up to the first one the cards disagree on are received fine, after that they are cleared
+	SimFrame &out = answers[0];
+	size_t collision = SIZE_MAX;
+	for (uint8_t a = 1; a < answerCount; a++) {
+		size_t bits = (answers[a].bits > out.bits) ? answers[a].bits : out.bits;
+		for (size_t i = 0; i < bits && i < collision; i++) {
+			bool mine = (i < out.bits) && GetBit(out.data, i);
+			bool theirs = (i < answers[a].bits) && GetBit(answers[a].data, i);
+			if (mine != theirs || i >= out.bits || i >= answers[a].bits) {
+				collision = i;
+			}
+		}
+		if (answers[a].bits > out.bits) {
+			out.bits = answers[a].bits;
+		}
+	}
+	if (collision != SIZE_MAX) {
+		for (size_t i = collision; i < out.bits; i++) {
+			out.data[i / 8] &= ~(1 << (i % 8));
+		}
+		out.data[collision / 8] |= 1 << (collision % 8);
+		regs[REG(ErrorReg)] |= 0x08;				// CollErr
+		regs[REG(CollReg)] = (regs[REG(CollReg)] & 0x80) | ((rxAlign + collision + 1) & 0x1F);
+	}
+	else {
+		regs[REG(CollReg)] = (regs[REG(CollReg)] & 0x80) | 0x20;	// CollPosNotValid
+	}
+	air = (uint64_t)(out.bits + out.bits / 8) * bitMicros + 86;		// Plus the frame delay time
+	simMicros += air;
+	stats.airMicros += air;
+
+	size_t bits = out.bits;
+	if ((regs[REG(RxModeReg)] & 0x80) && bits % 8 == 0) {
+		uint8_t crc[2];
+		size_t len = bits / 8;
+		if (len < 2) {
+			regs[REG(ErrorReg)] |= 0x04;			// CRCErr
+		}
+		else {
+			SimCard::Crc(out.data, len - 2, crc);
+			if (crc[0] != out.data[len - 2] || crc[1] != out.data[len - 1]) {
+				regs[REG(ErrorReg)] |= 0x04;
+			}
+			bits -= 16;
+		}
+	}
+
+	// Into the FIFO, the first bit at position RxAlign of the first byte
+	memset(fifo, 0, sizeof(fifo));
+	size_t total = rxAlign + bits;
+	if (total > sizeof(fifo) * 8) {
+		regs[REG(ErrorReg)] |= 0x10;				// BufferOvfl
+		total = sizeof(fifo) * 8;
+	}
+	for (size_t i = rxAlign; i < total; i++) {
+		if (GetBit(out.data, i - rxAlign)) {
+			fifo[i / 8] |= 1 << (i % 8);
+		}
+	}
+	fifoLength = (total + 7) / 8;
+	regs[REG(ControlReg)] = (regs[REG(ControlReg)] & ~0x07) | (total % 8);	// RxLastBits
+	regs[REG(ComIrqReg)] |= 0x20;					// RxIRq
+	if (regs[REG(ErrorReg)]) {
+		regs[REG(ComIrqReg)] |= 0x02;				// ErrIRq
+	}
+}
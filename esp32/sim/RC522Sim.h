@@ -0,0 +1,65 @@
+// A simulated MFRC522 behind the MFRC522Transport interface, for running the driver on a Linux host.
+// It models the registers the driver uses, the 64 byte FIFO, the commands (Transceive, MFAuthent, CalcCRC,
+// Mem, SoftReset and the self-test) and ISO/IEC 14443A framing: bit oriented frames, RxAlign, CRC_A,
+// collisions between several cards and the timer for missing answers. Cards are SimCard objects.
+//
+// Time is virtual (see Arduino.h). Register accesses advance it by the SPI transfer time, frames by their
+// air time at 106 kBit/s plus the frame delay time. A missing answer sets TimerIRq only once the programmed
+// timer period has passed, so the driver polls ComIrqReg meanwhile like on the real chip. These are
+// estimates from the datasheets, good for comparing access patterns, not for absolute numbers.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "MFRC522Transport.h"
+#include "SimCards.h"
+
+class RC522Sim : public MFRC522Transport {
+public:
+	struct Stats {
+		uint32_t transactions = 0;		// Bus transactions (one per chip select)
+		uint32_t registerReads = 0;
+		uint32_t registerWrites = 0;
+		uint32_t bytes = 0;				// Bytes on the bus, address bytes included
+		uint32_t frames = 0;			// Frames sent to the cards
+		uint32_t timeouts = 0;			// Frames nobody answered
+		uint64_t busMicros = 0;
+		uint64_t airMicros = 0;
+	};
+
+	static const uint8_t MAX_CARDS = 4;
+
+	RC522Sim();
+
+	void Begin() override {}
+	void SetClock(uint32_t clock) override { this->clock = clock; }
+	void WriteRegister(uint8_t reg, uint8_t count, const uint8_t *values) override;
+	void ReadRegister(uint8_t reg, uint8_t count, uint8_t *values) override;
+	void WriteFrames(uint8_t *frames, uint8_t length) override;
+
+	bool AddCard(SimCard *card);		// Brings a card into the field
+	void RemoveCard(SimCard *card);		// Takes it out again, it loses power
+	const Stats &GetStats() const { return stats; }
+	void ResetStats() { stats = Stats(); }
+
+private:
+	uint8_t regs[64];
+	uint8_t fifo[64];
+	uint8_t fifoLength;
+	bool fieldOn;
+	uint8_t internalBuffer[25];			// Filled by the Mem command
+	uint32_t clock = 4000000;
+	uint64_t timerIrqAt = 0;			// Virtual time TimerIRq is set at, 0 while the timer is not running
+	SimCard *cards[MAX_CARDS] = {};
+	Stats stats;
+
+	void Reset();
+	void Write(uint8_t address, uint8_t value);
+	uint8_t Read(uint8_t address);
+	void Execute(uint8_t command);
+	void Transceive();
+	void Authenticate();
+	void UpdateField();
+	void BusTime(uint8_t count);
+	uint64_t TimerMicros() const;
+	void StartTimer();
+};
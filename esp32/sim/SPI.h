@@ -0,0 +1,19 @@
+// Declarations only, so MFRC522TransportSPI compiles on the host. The simulator never uses it.
+#pragma once
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+
+struct SPISettings {
+	SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+public:
+	void begin() {}
+	void beginTransaction(SPISettings) {}
+	void endTransaction() {}
+	uint8_t transfer(uint8_t) { return 0; }
+	void transfer(void *, size_t) {}
+};
+extern SPIClass SPI;
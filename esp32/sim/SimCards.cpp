@@ -0,0 +1,466 @@
+#include "SimCards.h"
+#include <string.h>
+
+static bool GetBit(const uint8_t *data, size_t i) { return (data[i / 8] >> (i % 8)) & 1; }
+static void PutBit(uint8_t *data, size_t i, bool value) {
+	if (value) data[i / 8] |= 1 << (i % 8);
+	else data[i / 8] &= ~(1 << (i % 8));
+}
+
+// ——— SimFrame ———
+
+void SimFrame::Set(const uint8_t *bytes, size_t len, bool crc) {
+	memcpy(data, bytes, len);
+	if (crc) {
+		SimCard::Crc(data, len, &data[len]);
+		len += 2;
+	}
+	bits = len * 8;
+}
+
+void SimFrame::Nibble(uint8_t value) {
+	data[0] = value & 0x0F;
+	bits = 4;
+}
+
+// ——— SimCard: ISO/IEC 14443-3 ———
+
+SimCard::SimCard(const uint8_t *uid, uint8_t uidSize, uint16_t atqa, uint8_t sak) : uidSize(uidSize), atqa(atqa), sak(sak) {
+	memcpy(this->uid, uid, uidSize);
+}
+
+void SimCard::Crc(const uint8_t *data, size_t len, uint8_t *result) {
+	uint16_t crc = 0x6363;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t b = data[i] ^ (crc & 0xFF);
+		b ^= b << 4;
+		crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+	}
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+}
+
+void SimCard::FieldOff() {
+	state = IDLE;
+	fromHalt = false;
+	level = 0;
+	Deactivate();
+}
+
+void SimCard::Fall() {
+	state = fromHalt ? HALT : IDLE;
+	level = 0;
+	Deactivate();
+}
+
+bool SimCard::Receive(const SimFrame &in, bool crypto1, SimFrame &out) {
+	out.bits = 0;
+
+	// REQA and WUPA are short frames of 7 bits
+	if (in.bits == 7) {
+		uint8_t command = in.data[0] & 0x7F;
+		if ((command == 0x26 && state == IDLE) || (command == 0x52 && (state == IDLE || state == HALT))) {
+			fromHalt = (state == HALT);
+			state = READY;
+			level = 0;
+			uint8_t answer[2] = { (uint8_t)(atqa & 0xFF), (uint8_t)(atqa >> 8) };
+			out.Set(answer, 2, false);
+			return true;
+		}
+		if (state == READY || state == ACTIVE) {
+			Fall();
+		}
+		return false;
+	}
+
+	if (state == READY) {
+		return Select(in, out);
+	}
+	if (state != ACTIVE) {
+		return false;
+	}
+
+	uint8_t check[2];
+	size_t len = in.Bytes();
+	if (in.bits % 8 != 0 || len < 3) {
+		Fall();
+		return false;
+	}
+	Crc(in.data, len - 2, check);
+	if (check[0] != in.data[len - 2] || check[1] != in.data[len - 1]) {
+		Fall();
+		return false;
+	}
+	len -= 2;
+	if (len == 2 && in.data[0] == 0x50 && in.data[1] == 0x00) {		// HLTA
+		state = HALT;
+		fromHalt = true;
+		Deactivate();
+		return false;
+	}
+	if (Command(in.data, len, crypto1, out)) {
+		return true;
+	}
+	Fall();
+	return false;
+}
+
+void SimCard::LevelBits(uint8_t bytes[5]) const {
+	const uint8_t lastLevel = (uidSize == 4) ? 0 : (uidSize == 7) ? 1 : 2;
+	const uint8_t *source = &uid[level * 3];
+	if (level < lastLevel) {
+		bytes[0] = 0x88;				// Cascade tag
+		memcpy(&bytes[1], source, 3);
+	}
+	else {
+		memcpy(bytes, source, 4);
+	}
+	bytes[4] = bytes[0] ^ bytes[1] ^ bytes[2] ^ bytes[3];
+}
+
+bool SimCard::Select(const SimFrame &in, SimFrame &out) {
+	if (in.bits < 16 || in.data[0] != 0x93 + 2 * level) {
+		Fall();
+		return false;
+	}
+	uint8_t levelBits[5];
+	LevelBits(levelBits);
+	const uint8_t nvb = in.data[1];
+
+	if (nvb == 0x70) {					// SELECT
+		uint8_t check[2];
+		Crc(in.data, 7, check);
+		if (in.bits != 72 || check[0] != in.data[7] || check[1] != in.data[8]) {
+			Fall();
+			return false;
+		}
+		if (memcmp(&in.data[2], levelBits, 5) != 0) {
+			return false;				// Another card is being selected, stay READY
+		}
+		const uint8_t lastLevel = (uidSize == 4) ? 0 : (uidSize == 7) ? 1 : 2;
+		uint8_t answer = (level == lastLevel) ? sak : 0x04;	// 0x04: UID not complete
+		out.Set(&answer, 1, true);
+		if (level == lastLevel) {
+			state = ACTIVE;
+		}
+		else {
+			level++;
+		}
+		return true;
+	}
+
+	// ANTICOLLISION: answer with the UID bits after the ones the PCD already knows
+	if ((nvb >> 4) < 2 || (nvb >> 4) > 6 || (nvb & 0x0F) > 7) {
+		Fall();
+		return false;
+	}
+	const size_t known = ((nvb >> 4) - 2) * 8 + (nvb & 0x0F);
+	if (known > 40 || in.bits != 16 + known) {
+		Fall();
+		return false;
+	}
+	for (size_t i = 0; i < known; i++) {
+		if (GetBit(&in.data[2], i) != GetBit(levelBits, i)) {
+			return false;				// Lost this round, stay READY
+		}
+	}
+	memset(out.data, 0, 5);
+	for (size_t i = known; i < 40; i++) {
+		PutBit(out.data, i - known, GetBit(levelBits, i));
+	}
+	out.bits = 40 - known;
+	return true;
+}
+
+// ——— MIFARE Classic 1K ———
+
+SimMifareClassic1K::SimMifareClassic1K(const uint8_t *uid4) : SimCard(uid4, 4, 0x0004, 0x08) {
+	memset(memory, 0, sizeof(memory));
+	memcpy(memory[0], uid4, 4);
+	memory[0][4] = uid4[0] ^ uid4[1] ^ uid4[2] ^ uid4[3];
+	memory[0][5] = 0x08;
+	memory[0][6] = 0x04;
+	for (uint8_t sector = 0; sector < 16; sector++) {
+		static const uint8_t transport[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+		memcpy(memory[sector * 4 + 3], transport, 16);
+	}
+}
+
+void SimMifareClassic1K::WriteBlock(uint8_t block, const uint8_t *data16) {
+	memcpy(memory[block], data16, 16);
+}
+
+bool SimMifareClassic1K::Authenticate(uint8_t command, uint8_t block, const uint8_t *key) {
+	if (state != ACTIVE || block >= 64 || (command != 0x60 && command != 0x61)) {
+		return false;
+	}
+	const uint8_t *trailer = memory[(block / 4) * 4 + 3];
+	if (memcmp(command == 0x60 ? &trailer[0] : &trailer[10], key, 6) != 0) {
+		Fall();
+		return false;
+	}
+	authSector = block / 4;
+	return true;
+}
+
+bool SimMifareClassic1K::Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) {
+	if (crypto1 != (authSector >= 0)) {
+		return false;					// Encryption out of step, the card cannot decode the frame
+	}
+	if (pendingWrite >= 0) {
+		uint8_t block = pendingWrite;
+		pendingWrite = -1;
+		if (len != 16) {
+			return false;
+		}
+		memcpy(memory[block], data, 16);
+		out.Nibble(0x0A);
+		return true;
+	}
+	if (len != 2 || (data[0] != 0x30 && data[0] != 0xA0)) {
+		out.Nibble(0x00);				// Invalid operation
+		Fall();
+		return true;
+	}
+	const uint8_t block = data[1];
+	if (block >= 64 || block / 4 != authSector || (data[0] == 0xA0 && block == 0)) {
+		out.Nibble(0x04);				// Not allowed
+		Fall();
+		return true;
+	}
+	if (data[0] == 0xA0) {
+		pendingWrite = block;
+		out.Nibble(0x0A);
+		return true;
+	}
+	uint8_t buffer[16];
+	memcpy(buffer, memory[block], 16);
+	if (block % 4 == 3) {
+		memset(buffer, 0, 6);			// Key A is never readable
+	}
+	out.Set(buffer, 16, true);
+	return true;
+}
+
+// ——— NTAG215 ———
+
+SimNtag215::SimNtag215(const uint8_t *uid7) : SimCard(uid7, 7, 0x0044, 0x00) {
+	memset(memory, 0, sizeof(memory));
+	memory[0][0] = uid7[0];
+	memory[0][1] = uid7[1];
+	memory[0][2] = uid7[2];
+	memory[0][3] = 0x88 ^ uid7[0] ^ uid7[1] ^ uid7[2];
+	memcpy(memory[1], &uid7[3], 4);
+	memory[2][0] = uid7[3] ^ uid7[4] ^ uid7[5] ^ uid7[6];
+	memory[2][1] = 0x48;
+	static const uint8_t cc[4] = { 0xE1, 0x10, 0x3E, 0x00 };
+	memcpy(memory[3], cc, 4);
+	static const uint8_t empty[4] = { 0x03, 0x00, 0xFE, 0x00 };
+	memcpy(memory[4], empty, 4);
+	static const uint8_t config[5][4] = {
+		{ 0x00, 0x00, 0x00, 0xBD }, { 0x04, 0x00, 0x00, 0xFF }, { 0x00, 0x05, 0x00, 0x00 },
+		{ 0xFF, 0xFF, 0xFF, 0xFF }, { 0x00, 0x00, 0x00, 0x00 }
+	};
+	memcpy(memory[130], config, sizeof(config));
+}
+
+void SimNtag215::WritePages(uint8_t page, const uint8_t *data, size_t len) {
+	memcpy(&memory[page][0], data, len);
+}
+
+bool SimNtag215::Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) {
+	(void)crypto1;
+	if (pendingWrite >= 0) {
+		uint8_t page = pendingWrite;
+		pendingWrite = -1;
+		if (len != 16) {
+			return false;
+		}
+		memcpy(memory[page], data, 4);
+		out.Nibble(0x0A);
+		return true;
+	}
+	uint8_t buffer[PAGES * 4];
+	switch (data[0]) {
+		case 0x60:						// GET_VERSION
+			if (len == 1) {
+				static const uint8_t version[8] = { 0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x11, 0x03 };
+				out.Set(version, 8, true);
+				return true;
+			}
+			break;
+		case 0x30:						// READ, 4 pages, rolls over to page 0
+			if (len == 2 && data[1] < PAGES) {
+				for (uint8_t i = 0; i < 4; i++) {
+					memcpy(&buffer[i * 4], memory[(data[1] + i) % PAGES], 4);
+				}
+				out.Set(buffer, 16, true);
+				return true;
+			}
+			break;
+		case 0x3A:						// FAST_READ
+			if (len == 3 && data[1] <= data[2] && data[2] < PAGES) {
+				size_t count = data[2] - data[1] + 1;
+				memcpy(buffer, memory[data[1]], count * 4);
+				out.Set(buffer, count * 4, true);
+				return true;
+			}
+			break;
+		case 0xA2:						// WRITE
+			if (len == 6 && data[1] >= 3 && data[1] < PAGES) {
+				for (uint8_t i = 0; i < 4; i++) {
+					// The capability container is OTP: bits can only be set
+					memory[data[1]][i] = (data[1] == 3) ? (memory[3][i] | data[2 + i]) : data[2 + i];
+				}
+				out.Nibble(0x0A);
+				return true;
+			}
+			break;
+		case 0xA0:						// COMPATIBILITY_WRITE
+			if (len == 2 && data[1] >= 4 && data[1] < PAGES) {
+				pendingWrite = data[1];
+				out.Nibble(0x0A);
+				return true;
+			}
+			break;
+		case 0x3C:						// READ_SIG
+			if (len == 2) {
+				memset(buffer, 0, 32);
+				out.Set(buffer, 32, true);
+				return true;
+			}
+			break;
+	}
+	out.Nibble(0x00);
+	Fall();
+	return true;
+}
+
+// ——— ISO-DEP, NFC Forum Type 4 ———
+
+SimIsoDep::SimIsoDep(const uint8_t *uid7, const uint8_t *ndef, uint16_t ndefLen) : SimCard(uid7, 7, 0x0344, 0x20) {
+	if (ndefLen > sizeof(ndefFile) - 2) {
+		ndefLen = sizeof(ndefFile) - 2;
+	}
+	ndefFile[0] = ndefLen >> 8;
+	ndefFile[1] = ndefLen & 0xFF;
+	memcpy(&ndefFile[2], ndef, ndefLen);
+	ndefFileLen = ndefLen + 2;
+}
+
+bool SimIsoDep::Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) {
+	(void)crypto1;
+	if (!layer4) {
+		if (len == 2 && data[0] == 0xE0) {	// RATS
+			static const uint8_t fsdTable[9] = { 16, 24, 32, 40, 48, 64, 96, 128, 255 };
+			fsd = fsdTable[(data[1] >> 4) < 9 ? (data[1] >> 4) : 8];
+			layer4 = true;
+			// TL, T0 (TA1 TB1 TC1 present, FSCI 8), TA1 (same D, up to 424 kBit/s), TB1, TC1 (CID supported)
+			static const uint8_t ats[5] = { 0x05, 0x78, 0x80, 0x70, 0x02 };
+			out.Set(ats, 5, true);
+			return true;
+		}
+		return false;
+	}
+
+	const uint8_t pcb = data[0];
+	const bool cid = pcb & 0x08;
+	const size_t header = 1 + (cid ? 1 : 0) + ((pcb & 0x04) ? 1 : 0);
+	if (len < header) {
+		return false;
+	}
+	if ((pcb & 0xF0) == 0xD0) {			// PPS, answered with its start byte
+		out.Set(data, 1, true);
+		return true;
+	}
+	if ((pcb & 0xE2) == 0x02) {			// I-block
+		if (pcb & 0x10) {
+			return false;				// Chaining from the PCD is not simulated
+		}
+		pendingLen = Apdu(&data[header], len - header, pending);
+		pendingOffset = 0;
+		SendBlock(0x02 | (pcb & 0x01), cid, out);
+		return true;
+	}
+	if ((pcb & 0xF6) == 0xA2) {			// R(ACK): next part of a chained response
+		if (pendingOffset >= pendingLen) {
+			return false;
+		}
+		SendBlock(0x02 | (pcb & 0x01), cid, out);
+		return true;
+	}
+	if ((pcb & 0xF7) == 0xC2) {			// S(DESELECT)
+		out.Set(data, header, true);
+		state = HALT;
+		fromHalt = true;
+		Deactivate();
+		return true;
+	}
+	return false;
+}
+
+void SimIsoDep::SendBlock(uint8_t pcb, bool cid, SimFrame &out) {
+	uint8_t frame[260];
+	size_t index = 0;
+	const size_t room = fsd - 3 - (cid ? 1 : 0);	// PCB, CID and CRC_A
+	size_t chunk = pendingLen - pendingOffset;
+	if (chunk > room) {
+		chunk = room;
+		pcb |= 0x10;					// More to come
+	}
+	frame[index++] = pcb | (cid ? 0x08 : 0x00);
+	if (cid) {
+		frame[index++] = 0x00;
+	}
+	memcpy(&frame[index], &pending[pendingOffset], chunk);
+	pendingOffset += chunk;
+	out.Set(frame, index + chunk, true);
+}
+
+size_t SimIsoDep::Apdu(const uint8_t *apdu, size_t len, uint8_t *response) {
+	static const uint8_t aid[7] = { 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+	const uint16_t maxNdef = sizeof(ndefFile);
+	const uint8_t cc[15] = {
+		0x00, 0x0F, 0x20, 0x00, 0x3B, 0x00, 0x34,		// CCLEN, mapping version 2.0, MLe 59, MLc 52
+		0x04, 0x06, 0xE1, 0x04, (uint8_t)(maxNdef >> 8), (uint8_t)(maxNdef & 0xFF), 0x00, 0xFF	// NDEF file control TLV, read only
+	};
+	size_t n = 0;
+	uint16_t sw = 0x6D00;				// INS not supported
+
+	if (len >= 5 && apdu[0] == 0x00 && apdu[1] == 0xA4) {	// SELECT
+		const uint8_t lc = apdu[4];
+		sw = 0x6A82;					// File not found
+		if (apdu[2] == 0x04 && lc == 7 && len >= 12 && memcmp(&apdu[5], aid, 7) == 0) {
+			appSelected = true;
+			selectedFile = 0;
+			sw = 0x9000;
+		}
+		else if (apdu[2] == 0x00 && lc == 2 && len >= 7 && appSelected) {
+			uint16_t fid = (apdu[5] << 8) | apdu[6];
+			if (fid == 0xE103 || fid == 0xE104) {
+				selectedFile = fid;
+				sw = 0x9000;
+			}
+		}
+	}
+	else if (len == 5 && apdu[0] == 0x00 && apdu[1] == 0xB0) {	// READ BINARY
+		const uint8_t *file = (selectedFile == 0xE103) ? cc : ndefFile;
+		const size_t fileLen = (selectedFile == 0xE103) ? sizeof(cc) : ndefFileLen;
+		const size_t offset = (apdu[2] << 8) | apdu[3];
+		const size_t le = apdu[4] ? apdu[4] : 256;
+		if (selectedFile == 0) {
+			sw = 0x6986;				// No file selected
+		}
+		else if (offset > fileLen) {
+			sw = 0x6B00;				// Wrong offset
+		}
+		else {
+			n = (fileLen - offset < le) ? fileLen - offset : le;
+			memcpy(response, &file[offset], n);
+			sw = 0x9000;
+		}
+	}
+	response[n++] = sw >> 8;
+	response[n++] = sw & 0xFF;
+	return n;
+}
@@ -0,0 +1,117 @@
+// Virtual PICCs for RC522Sim: the ISO/IEC 14443-3 state machine shared by all cards,
+// plus MIFARE Classic 1K, NTAG215 and an ISO-DEP (Type 4) card with an NDEF file.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// A frame on the air. Bits go out LSB first, starting with data[0].
+struct SimFrame {
+	uint8_t data[300];
+	size_t bits = 0;
+
+	size_t Bytes() const { return (bits + 7) / 8; }
+	void Set(const uint8_t *bytes, size_t len, bool crc);	// Whole bytes, optionally followed by CRC_A
+	void Nibble(uint8_t value);								// 4 bit ACK/NAK
+};
+
+class SimCard {
+public:
+	SimCard(const uint8_t *uid, uint8_t uidSize, uint16_t atqa, uint8_t sak);
+	virtual ~SimCard() {}
+
+	// A frame from the PCD while the field is on. crypto1 mirrors Status2Reg.MFCrypto1On.
+	// Returns false if the card does not answer.
+	bool Receive(const SimFrame &in, bool crypto1, SimFrame &out);
+	// The MFAuthent command. Only MIFARE Classic cards accept it.
+	virtual bool Authenticate(uint8_t command, uint8_t block, const uint8_t *key) { (void)command; (void)block; (void)key; return false; }
+	// The field was switched off: all state is lost.
+	void FieldOff();
+
+	const uint8_t *Uid() const { return uid; }
+	uint8_t UidSize() const { return uidSize; }
+
+	static void Crc(const uint8_t *data, size_t len, uint8_t *result);
+
+protected:
+	enum State { IDLE, READY, ACTIVE, HALT };
+
+	// A frame for the card in ACTIVE state, CRC_A already checked and removed.
+	// Return false to stay silent, which also sends the card back to IDLE (or HALT).
+	virtual bool Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) = 0;
+	// Drops everything above layer 3 (authentication, ISO-DEP session, pending writes).
+	virtual void Deactivate() {}
+
+	void Fall();					// Back to IDLE, or HALT if the card was woken from HALT
+
+	uint8_t uid[10];
+	uint8_t uidSize;
+	uint16_t atqa;
+	uint8_t sak;
+	State state = IDLE;
+	bool fromHalt = false;			// Woken by WUPA from HALT, falls back there
+	uint8_t level = 0;				// Cascade level being selected
+
+private:
+	void LevelBits(uint8_t bytes[5]) const;		// UID CLn (with cascade tag) and BCC of the current level
+	bool Select(const SimFrame &in, SimFrame &out);
+};
+
+// MIFARE Classic 1K: 16 sectors of 4 blocks. Crypto1 is not simulated: the RC522 encrypts and
+// decrypts transparently, so only whether authentication happened matters to the driver.
+class SimMifareClassic1K : public SimCard {
+public:
+	SimMifareClassic1K(const uint8_t *uid4);
+	bool Authenticate(uint8_t command, uint8_t block, const uint8_t *key) override;
+	void WriteBlock(uint8_t block, const uint8_t *data16);	// Direct access, for preparing a card
+	const uint8_t *Block(uint8_t block) const { return memory[block]; }
+
+protected:
+	bool Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) override;
+	void Deactivate() override { authSector = -1; pendingWrite = -1; }
+
+private:
+	uint8_t memory[64][16];
+	int authSector = -1;
+	int pendingWrite = -1;			// Block of a WRITE waiting for its data frame
+};
+
+// NTAG215: 135 pages of 4 bytes, 504 bytes of user memory from page 4 on.
+class SimNtag215 : public SimCard {
+public:
+	static const uint8_t PAGES = 135;
+
+	SimNtag215(const uint8_t *uid7);
+	void WritePages(uint8_t page, const uint8_t *data, size_t len);	// Direct access, for preparing a tag
+
+protected:
+	bool Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) override;
+	void Deactivate() override { pendingWrite = -1; }
+
+private:
+	uint8_t memory[PAGES][4];
+	int pendingWrite = -1;			// Page of a COMPATIBILITY_WRITE waiting for its data frame
+};
+
+// ISO/IEC 14443-4 card with the NFC Forum Type 4 NDEF application (like an NTAG 424 DNA).
+class SimIsoDep : public SimCard {
+public:
+	SimIsoDep(const uint8_t *uid7, const uint8_t *ndef, uint16_t ndefLen);
+
+protected:
+	bool Command(const uint8_t *data, size_t len, bool crypto1, SimFrame &out) override;
+	void Deactivate() override { layer4 = false; selectedFile = 0; pendingLen = 0; }
+
+private:
+	uint8_t ndefFile[1024];			// NLEN + message
+	uint16_t ndefFileLen;
+	bool layer4 = false;			// RATS received
+	bool appSelected = false;
+	uint16_t selectedFile = 0;
+	uint8_t fsd = 16;				// Largest frame the PCD accepts, from RATS
+	uint8_t pending[300];			// Response APDU still to be sent in chained blocks
+	size_t pendingLen = 0;
+	size_t pendingOffset = 0;
+
+	size_t Apdu(const uint8_t *apdu, size_t len, uint8_t *response);
+	void SendBlock(uint8_t pcb, bool cid, SimFrame &out);
+};
@@ -0,0 +1,308 @@
+// Runs the MFRC522 driver against RC522Sim and prints what each operation costs on the bus and on the air.
+// NdefStream from libraries/SpotifyNfc runs against the simulated NTAG215 as well.
+// Build and run from the esp32 folder:
+//   g++ -std=gnu++11 -O1 -DARDUINO=10800 -DMFRC522_NO_I2C -Isim -I. -I../libraries/SpotifyNfc/src sim/*.cpp MFRC522.cpp MFRC522Extended.cpp MFRC522Transport.cpp ../libraries/SpotifyNfc/src/NdefStream.cpp ../libraries/SpotifyNfc/src/SpotifyNdef.cpp -o rc522sim && ./rc522sim
+// Exits with 1 if any scenario fails, so it can gate driver changes.
+// Built with -DMFRC522_ENABLE_TRACE=1 -DMFRC522_TRACE_SIZE=4096 and MFRC522Trace.cpp, "./rc522sim trace" also dumps the register
+// trace of all scenarios, for trying out trace_phases.py.
+#include <Arduino.h>
+#include "MFRC522Extended.h"
+#include "RC522Sim.h"
+#include "NdefStream.h"
+
+static RC522Sim chip;
+static MFRC522Extended mfrc522(chip);
+static int failures = 0;
+#if MFRC522_ENABLE_TRACE
+static MFRC522Trace trace;
+#endif
+
+static uint64_t startMicros;
+
+static void Begin() {
+	chip.ResetStats();
+	startMicros = simMicros;
+}
+
+static void End(const char *name, bool ok) {
+	const RC522Sim::Stats &stats = chip.GetStats();
+	printf("%-34s %-4s %6u transactions %6u bytes %4u frames %8lu us (bus %lu, air %lu)\n",
+		name, ok ? "ok" : "FAIL", stats.transactions, stats.bytes, stats.frames,
+		(unsigned long)(simMicros - startMicros), (unsigned long)stats.busMicros, (unsigned long)stats.airMicros);
+	if (!ok) {
+		failures++;
+	}
+}
+
+static bool SameUid(const MFRC522::Uid &uid, const SimCard &card) {
+	return uid.size == card.UidSize() && memcmp(uid.uidByte, card.Uid(), uid.size) == 0;
+}
+
+static void ClassicScenarios() {
+	static const uint8_t uid[4] = { 0xDE, 0xAD, 0xBE, 0xEF };
+	SimMifareClassic1K card(uid);
+	uint8_t data[48];
+	for (uint8_t i = 0; i < sizeof(data); i++) {
+		data[i] = i * 7 + 1;
+	}
+	card.WriteBlock(4, &data[0]);
+	card.WriteBlock(5, &data[16]);
+	card.WriteBlock(6, &data[32]);
+	chip.AddCard(&card);
+
+	Begin();
+	bool ok = mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial() && SameUid(mfrc522.uid, card);
+	End("Classic 1K detect and select", ok);
+
+	Begin();
+	MFRC522::MIFARE_Key key;
+	memset(key.keyByte, 0xFF, sizeof(key.keyByte));
+	ok = ok && mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &mfrc522.uid) == MFRC522::STATUS_OK;
+	for (uint8_t block = 4; ok && block < 7; block++) {
+		uint8_t buffer[18];
+		uint8_t size = sizeof(buffer);
+		ok = mfrc522.MIFARE_Read(block, buffer, &size) == MFRC522::STATUS_OK && memcmp(buffer, card.Block(block), 16) == 0;
+	}
+	End("Classic 1K auth + 3 block reads", ok);
+
+	Begin();
+	uint8_t block[16] = { 0x55 };
+	ok = ok && mfrc522.MIFARE_Write(5, block, 16) == MFRC522::STATUS_OK && memcmp(card.Block(5), block, 16) == 0;
+	End("Classic 1K block write", ok);
+
+	// The card stays silent until the 25ms timer fires. At 10MHz the driver reads ComIrqReg far more often
+	// while it waits, which must still count as a PICC timeout and not as a chip that stopped answering.
+	Begin();
+	memset(key.keyByte, 0x00, sizeof(key.keyByte));
+	mfrc522.PCD_SetSPIClock(10000000u);
+	uint32_t chipTimeouts = mfrc522.PCD_GetErrorCounters().chipTimeouts;
+	ok = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 8, &key, &mfrc522.uid) == MFRC522::STATUS_TIMEOUT
+		&& mfrc522.PCD_GetErrorCounters().chipTimeouts == chipTimeouts;
+	mfrc522.PCD_SetSPIClock(MFRC522_SPICLOCK);
+	End("Classic 1K wrong key, 10MHz SPI", ok);
+
+	// ReaderManager gives each slot a deadline. The timer must be cut to it instead of running its 25ms.
+	Begin();
+	uint32_t deadlines = mfrc522.PCD_GetErrorCounters().deadlines;
+	mfrc522.PCD_SetDeadline(millis() + 5);
+	ok = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 8, &key, &mfrc522.uid) == MFRC522::STATUS_TIMEOUT
+		&& mfrc522.PCD_GetErrorCounters().deadlines == deadlines + 1 && simMicros - startMicros < 6000;
+	mfrc522.PCD_ClearDeadline();
+	End("Classic 1K wrong key, 5ms deadline", ok);
+	mfrc522.PCD_StopCrypto1();
+	mfrc522.PICC_HaltA();
+	chip.RemoveCard(&card);
+}
+
+static void NtagScenarios() {
+	static const uint8_t uid[7] = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+	SimNtag215 tag(uid);
+	uint8_t ndef[120] = { 0x03, 0x70 };
+	for (uint8_t i = 2; i < 114; i++) {
+		ndef[i] = i;
+	}
+	ndef[114] = 0xFE;
+	tag.WritePages(4, ndef, sizeof(ndef));
+	chip.AddCard(&tag);
+
+	Begin();
+	bool ok = mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial() && SameUid(mfrc522.uid, tag);
+	End("NTAG215 detect and select", ok);
+
+	Begin();
+	uint8_t memory[504];
+	uint16_t size = sizeof(memory);
+	ok = ok && mfrc522.NTAG_ReadUserMemory(memory, &size) == MFRC522::STATUS_OK && size == 504 && memcmp(memory, ndef, sizeof(ndef)) == 0;
+	End("NTAG215 user memory, FAST_READ", ok);
+
+	Begin();
+	ok = true;
+	for (uint8_t page = 4; ok && page < 4 + 504 / 4; page += 4) {
+		uint8_t buffer[18];
+		uint8_t length = sizeof(buffer);
+		ok = mfrc522.MIFARE_Read(page, buffer, &length) == MFRC522::STATUS_OK;
+		size_t offset = (page - 4) * 4;
+		size_t count = (offset + 16 <= 504) ? 16 : 504 - offset;
+		ok = ok && memcmp(buffer, &memory[offset], count) == 0;
+	}
+	End("NTAG215 user memory, READ", ok);
+	mfrc522.PICC_HaltA();
+	chip.RemoveCard(&tag);
+}
+
+// A short NDEF URI record for uri. header adds MB (0x80) and ME (0x40). Returns its length.
+static size_t UriRecord(uint8_t header, const char *uri, uint8_t *out) {
+	out[0] = header | 0x10 | SpotifyNdef::TNF_WELL_KNOWN;	// SR
+	out[1] = 1;
+	out[2] = SpotifyNdef::UriRecordPayload(uri, &out[4], 250);
+	out[3] = 'U';
+	return 4 + out[2];
+}
+
+// Puts data on an NTAG215 from page 4 on and streams it. The tag is detected before the measurement starts.
+static void StreamScenario(const char *name, const uint8_t *data, size_t len, NdefStream::Result expected,
+		const char *expectedUri, uint16_t maxBytesRead) {
+	static const uint8_t uid[7] = { 0x04, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76 };
+	SimNtag215 tag(uid);
+	if (len > 0) {
+		tag.WritePages(4, data, len);
+	}
+	chip.AddCard(&tag);
+	bool ok = mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial();
+
+	Begin();
+	NdefStream stream(mfrc522);
+	char uri[SpotifyNdef::URI_SIZE];
+	ok = ok && stream.FindSpotifyUri(uri, sizeof(uri)) == expected && strcmp(uri, expectedUri) == 0
+		&& stream.GetBytesRead() <= maxBytesRead;
+	char label[64];
+	snprintf(label, sizeof(label), "%s, %u B", name, stream.GetBytesRead());
+	End(label, ok);
+	mfrc522.PICC_HaltA();
+	chip.RemoveCard(&tag);
+}
+
+static void NdefStreamScenarios() {
+	static const char id[] = "3Rr99zTIYQ15YEITCS0tNS";
+	char spotifyUri[48], link[80];
+	snprintf(spotifyUri, sizeof(spotifyUri), "spotify:album:%s", id);
+	snprintf(link, sizeof(link), "https://open.spotify.com/album/%s?si=abc", id);
+	uint8_t tag[504];
+	size_t n;
+
+	// A 300 byte MIME record before the URI: long record format, skipped without reading its payload
+	static const char mime[] = "application/octet-stream";
+	const uint16_t mimeLength = 1 + 1 + 4 + sizeof(mime) - 1 + 300;
+	uint8_t uriRecord[128];
+	size_t uriLength = UriRecord(0x40, spotifyUri, uriRecord);
+	uint16_t messageLength = mimeLength + uriLength;
+	n = 0;
+	tag[n++] = 0x03;
+	tag[n++] = 0xFF;
+	tag[n++] = messageLength >> 8;
+	tag[n++] = messageLength & 0xFF;
+	tag[n++] = 0x80 | 0x02;								// MB, TNF media type
+	tag[n++] = sizeof(mime) - 1;
+	tag[n++] = 0x00;
+	tag[n++] = 0x00;
+	tag[n++] = 300 >> 8;
+	tag[n++] = 300 & 0xFF;
+	memcpy(&tag[n], mime, sizeof(mime) - 1);
+	n += sizeof(mime) - 1;
+	memset(&tag[n], 0xA5, 300);
+	n += 300;
+	memcpy(&tag[n], uriRecord, uriLength);
+	n += uriLength;
+	tag[n++] = 0xFE;
+	StreamScenario("NDEF URI after 300 B MIME", tag, n, NdefStream::FOUND, spotifyUri, 160);
+
+	// The URI first, followed by a long text record that is never read
+	n = 0;
+	tag[n++] = 0x03;
+	tag[n++] = 0xFF;
+	n += 2;
+	n += UriRecord(0x80, link, &tag[n]);
+	tag[n++] = 0x40 | 0x10 | SpotifyNdef::TNF_WELL_KNOWN;	// ME, SR, 'T'
+	tag[n++] = 1;
+	tag[n++] = 200;
+	tag[n++] = 'T';
+	memset(&tag[n], 'x', 200);
+	n += 200;
+	tag[2] = (n - 4) >> 8;
+	tag[3] = (n - 4) & 0xFF;
+	tag[n++] = 0xFE;
+	StreamScenario("NDEF URI first", tag, n, NdefStream::FOUND, spotifyUri, 80);
+
+	// The empty NDEF message every new NTAG215 comes with
+	StreamScenario("NDEF empty message", nullptr, 0, NdefStream::NOT_FOUND, "", 16);
+
+	// The record claims more bytes than its TLV holds. The URI is complete on the tag, but must not be used.
+	n = 0;
+	tag[n++] = 0x03;
+	tag[n++] = 10;
+	n += UriRecord(0xC0, spotifyUri, &tag[n]);
+	tag[n++] = 0xFE;
+	StreamScenario("NDEF record overruns its TLV", tag, n, NdefStream::NOT_FOUND, "", 64);
+}
+
+static void IsoDepScenarios() {
+	static const uint8_t uid[7] = { 0x04, 0x51, 0x62, 0x73, 0x84, 0x95, 0xA6 };
+	// A short NDEF text record
+	static const uint8_t message[] = { 0xD1, 0x01, 0x08, 'T', 0x02, 'e', 'n', 'h', 'e', 'l', 'l', 'o' };
+	uint8_t ndef[300];
+	memcpy(ndef, message, sizeof(message));
+	for (size_t i = sizeof(message); i < sizeof(ndef); i++) {
+		ndef[i] = (uint8_t)i;
+	}
+	SimIsoDep card(uid, ndef, sizeof(ndef));
+	chip.AddCard(&card);
+
+	Begin();
+	bool ok = mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial() && SameUid(mfrc522.uid, card)
+		&& mfrc522.tag.ats.size > 0;
+	End("ISO-DEP detect, select and RATS", ok);
+
+	Begin();
+	uint8_t buffer[512];
+	uint16_t size = sizeof(buffer);
+	ok = ok && mfrc522.TCL_ReadNdef(&mfrc522.tag, buffer, &size) == MFRC522::STATUS_OK && size == sizeof(ndef)
+		&& memcmp(buffer, ndef, sizeof(ndef)) == 0;
+	End("ISO-DEP NDEF file, 300 bytes", ok);
+	mfrc522.TCL_Deselect(&mfrc522.tag);
+	chip.RemoveCard(&card);
+}
+
+static void TwoCardScenario() {
+	static const uint8_t uidA[4] = { 0x12, 0x34, 0x56, 0x78 };
+	static const uint8_t uidB[4] = { 0x1A, 0x34, 0x56, 0x78 };
+	SimMifareClassic1K cardA(uidA), cardB(uidB);
+	chip.AddCard(&cardA);
+	chip.AddCard(&cardB);
+
+	Begin();
+	MFRC522::Uid uids[4];
+	bool ok = mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_SelectAll(uids, 4) == 2;
+	ok = ok && ((SameUid(uids[0], cardA) && SameUid(uids[1], cardB)) || (SameUid(uids[0], cardB) && SameUid(uids[1], cardA)));
+	End("Two cards, anticollision", ok);
+
+	Begin();
+	ok = ok && mfrc522.PICC_WakeupAndSelect(&uids[1]) == MFRC522::STATUS_OK && SameUid(mfrc522.uid, SameUid(uids[1], cardA) ? cardA : cardB);
+	End("Two cards, wake and select one", ok);
+	mfrc522.PICC_HaltA();
+	chip.RemoveCard(&cardA);
+	chip.RemoveCard(&cardB);
+}
+
+int main(int argc, char **argv) {
+#if MFRC522_ENABLE_TRACE
+	mfrc522.PCD_SetTrace(&trace);
+#endif
+	Begin();
+	mfrc522.PCD_Init();
+	End("PCD_Init", mfrc522.PCD_ReadRegister(MFRC522::VersionReg) == 0x92);
+
+	Begin();
+	bool ok = mfrc522.PCD_PerformSelfTest();
+	mfrc522.PCD_Init();
+	End("Self-test", ok);
+
+	Begin();
+	End("Poll, no card", !mfrc522.PICC_IsNewCardPresent());
+
+	ClassicScenarios();
+	NtagScenarios();
+	NdefStreamScenarios();
+	IsoDepScenarios();
+	TwoCardScenario();
+
+	printf("%s\n", failures ? "FAILED" : "All scenarios passed");
+#if MFRC522_ENABLE_TRACE
+	if (argc > 1 && strcmp(argv[1], "trace") == 0) {
+		trace.Dump(Serial);
+	}
+#else
+	(void)argc;
+	(void)argv;
+#endif
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,3 @@
+// Stands in for the deprecated.h of the MFRC522 library, which this folder does not carry.
+// Nothing in the driver copy uses its macros.
+#pragma once
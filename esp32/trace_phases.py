@@ -0,0 +1,145 @@
+# Splits an MFRC522 register trace (MFRC522Trace::Dump(), eg from the "trace" telnet command) into
+# protocol phases and prints the time spent in each.
+#
+#   python3 trace_phases.py trace.txt         # summary per phase
+#   python3 trace_phases.py -v trace.txt      # plus every phase on its own line
+#
+# A phase starts where the driver flushes the FIFO to load a new command and is named after that command:
+# reqa, select, auth, read, write, halt, rats, iso-dep, version, crc (only with MFRC522_SOFTWARE_CRC 0), other.
+# Its time runs from its first to its last register access. Time between phases is "host" when shorter than
+# --idle microseconds (decoding, logging) and "idle" when longer (the poll interval).
+
+import argparse
+import re
+import sys
+
+COMMAND_REG = 0x01
+COM_IRQ_REG = 0x04
+FIFO_DATA_REG = 0x09
+FIFO_LEVEL_REG = 0x0A
+
+PCD_CALC_CRC = 0x03
+PCD_TRANSCEIVE = 0x0C
+PCD_MF_AUTHENT = 0x0E
+
+LINE = re.compile(r"^\s*(\d+) ([RW]) ([0-9A-Fa-f]{2}) (\d+) ([0-9A-Fa-f]{2})\s*$")
+
+
+def parse(lines):
+    entries = []
+    for line in lines:
+        match = LINE.match(line)
+        if match:
+            micros, op, address, count, value = match.groups()
+            entries.append((int(micros), op == "R", int(address, 16), int(count), int(value, 16)))
+    return entries
+
+
+def name_phase(command, first, count):
+    if command == PCD_MF_AUTHENT:
+        return "auth"
+    if command == PCD_CALC_CRC:
+        return "crc"
+    if command != PCD_TRANSCEIVE or first is None:
+        return "other"
+    if first in (0x26, 0x52) and count == 1:
+        return "reqa"
+    if first in (0x93, 0x95, 0x97):
+        return "select"
+    if first in (0x30, 0x3A):
+        return "read"
+    if (first == 0xA2 and count in (6, 8)) or (first == 0xA0 and count == 4) or count == 18:
+        return "write"              # NTAG WRITE, MIFARE WRITE step 1, or its 16 byte data frame
+    if first == 0x50:
+        return "halt"
+    if first == 0x60 and count <= 3:
+        return "version"
+    if first == 0xE0:
+        return "rats"
+    if first & 0xE2 == 0x02 or first & 0xE6 == 0xA2 or first & 0xC7 == 0xC2:
+        return "iso-dep"            # I-, R- and S-blocks
+    return "other"
+
+
+def split(entries):
+    """Returns a list of phases: [name, first index, last index]."""
+    phases = []
+    start = 0
+    for i in range(1, len(entries) + 1):
+        boundary = i == len(entries) or (not entries[i][1] and entries[i][2] == FIFO_LEVEL_REG and entries[i][4] & 0x80)
+        if not boundary:
+            continue
+        command, first, count = None, None, 0
+        for micros, read, address, n, value in entries[start:i]:
+            if read:
+                continue
+            if address == FIFO_DATA_REG and first is None:
+                first, count = value, n
+            elif address == COMMAND_REG and value & 0x0F not in (0x00, 0x07):
+                command = value & 0x0F
+        phases.append([name_phase(command, first, count), start, i - 1])
+        start = i
+    # Setup writes queued before the flush (Idle, ComIrqReg, timer) belong to the next phase
+    for phase, following in zip(phases, phases[1:]):
+        last = phase[2]
+        while last > phase[1] and not entries[last][1] and entries[last][0] == entries[following[1]][0]:
+            last -= 1
+        following[1] = last + 1
+        phase[2] = last
+    return phases
+
+
+def elapsed(a, b):
+    return (b - a) & 0xFFFFFFFF     # micros() wraps after 71 minutes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("trace", nargs="?", type=argparse.FileType("r"), default=sys.stdin)
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every phase")
+    parser.add_argument("--idle", type=int, default=5000, help="gaps longer than this many us are idle time")
+    args = parser.parse_args()
+
+    entries = parse(args.trace)
+    if not entries:
+        sys.exit("No trace entries found")
+
+    totals = {}
+    order = []
+
+    def add(name, micros, ops=0, size=0, timeouts=0):
+        if name not in totals:
+            totals[name] = [0, 0, 0, 0, 0]
+            order.append(name)
+        total = totals[name]
+        total[0] += 1
+        total[1] += micros
+        total[2] += ops
+        total[3] += size
+        total[4] += timeouts
+
+    phases = split(entries)
+    for index, (name, first, last) in enumerate(phases):
+        span = entries[first:last + 1]
+        micros = elapsed(span[0][0], span[-1][0])
+        size = sum(entry[3] + 1 for entry in span)
+        timeouts = sum(1 for entry in span if entry[1] and entry[2] == COM_IRQ_REG and entry[4] & 0x01)
+        add(name, micros, len(span), size, timeouts)
+        if args.verbose:
+            print("%10d %-8s %7d us %4d ops %5d bytes%s" % (span[0][0], name, micros, len(span), size,
+                                                          " timeout" if timeouts else ""))
+        if index + 1 < len(phases):
+            gap = elapsed(span[-1][0], entries[phases[index + 1][1]][0])
+            add("host" if gap < args.idle else "idle", gap)
+
+    busy = sum(total[1] for name, total in totals.items() if name != "idle")
+    print("%-8s %6s %10s %9s %7s %8s %8s %6s" % ("phase", "count", "total us", "mean us", "share", "bus ops", "bytes", "t/o"))
+    for name in order:
+        count, micros, ops, size, timeouts = totals[name]
+        share = "" if name == "idle" or busy == 0 else "%5.1f%%" % (100.0 * micros / busy)
+        print("%-8s %6d %10d %9d %7s %8d %8d %6d" % (name, count, micros, micros // count, share, ops, size, timeouts))
+    print("%d entries, %d us busy (without idle)" % (len(entries), busy))
+
+
+if __name__ == "__main__":
+    main()
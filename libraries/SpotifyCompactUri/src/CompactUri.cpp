@@ -0,0 +1,82 @@
+#include "CompactUri.h"
+
+// Index + 1 is the type code stored in the low nibble of the first byte
+const char* const CompactUri::TYPES[] = { "track", "album", "artist", "playlist", "episode", "show" };
+const byte CompactUri::TYPE_COUNT = sizeof(TYPES) / sizeof(TYPES[0]);
+// Digit order used by Spotify for its base62 IDs
+const char CompactUri::ALPHABET[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+bool CompactUri::Encode(const String& uri, byte out[SIZE]) {
+    String rest = uri;
+    if (rest.startsWith("spotify:")) rest = rest.substring(8);
+
+    int colon = rest.indexOf(':');
+    if (colon < 0) return false;
+    String type = rest.substring(0, colon);
+    String id = rest.substring(colon + 1);
+    if (id.length() != 22) return false;
+
+    byte code = 0;
+    for (byte i = 0; i < TYPE_COUNT; i++) {
+        if (type == TYPES[i]) { code = i + 1; break; }
+    }
+    if (code == 0) return false;
+
+    // id = sum(digit * 62^k), accumulated into 16 bytes big endian
+    byte* value = out + 1;
+    memset(value, 0, 16);
+    for (byte i = 0; i < 22; i++) {
+        const char* pos = strchr(ALPHABET, id[i]);
+        if (pos == nullptr || *pos == '\0') return false;
+        uint16_t carry = pos - ALPHABET;
+        for (int j = 15; j >= 0; j--) {
+            uint16_t v = value[j] * 62 + carry;
+            value[j] = v & 0xFF;
+            carry = v >> 8;
+        }
+        if (carry) return false;   // Larger than 128 bits, not a Spotify ID
+    }
+
+    out[0] = 0xC0 | code;
+    Crc(out, 17, out + 17);
+    return true;
+}
+
+bool CompactUri::Decode(const byte* data, size_t len, String& uri) {
+    if (len < SIZE || !IsCompact(data, len)) return false;
+    byte code = data[0] & 0x0F;
+    if (code == 0 || code > TYPE_COUNT) return false;
+    byte crc[2];
+    Crc(data, 17, crc);
+    if (data[17] != crc[0] || data[18] != crc[1]) return false;
+
+    // Repeated division by 62 gives the digits from the least significant one
+    byte value[16];
+    memcpy(value, data + 1, 16);
+    char id[23];
+    id[22] = '\0';
+    for (int i = 21; i >= 0; i--) {
+        uint16_t remainder = 0;
+        for (byte j = 0; j < 16; j++) {
+            uint16_t v = (remainder << 8) | value[j];
+            value[j] = v / 62;
+            remainder = v % 62;
+        }
+        id[i] = ALPHABET[remainder];
+    }
+
+    uri = String(TYPES[code - 1]) + ":" + id;
+    return true;
+}
+
+void CompactUri::Crc(const byte* data, byte len, byte out[2]) {
+    uint16_t crc = 0x6363;
+    for (byte i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (byte b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+        }
+    }
+    out[0] = crc & 0xFF;
+    out[1] = crc >> 8;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+
+// Binary form of a Spotify URI such as "album:3Rr99zTIYQ15YEITCS0tNS" for cards:
+//   [0xC0 | type] [ID, 16 bytes big endian] [CRC_A, 2 bytes, low byte first]
+// A Spotify ID is a 128-bit number written as 22 base62 digits, so it packs into 16 bytes.
+// The first byte is never ASCII, which tells the compact form apart from text cards.
+// The 19 bytes fill blocks 4 and 5 of a MIFARE Classic card, both in sector 1, or five NTAG pages.
+class CompactUri {
+public:
+    static const byte SIZE = 19;
+
+    // Encodes "type:id" or "spotify:type:id". False if the URI has no compact form, for example
+    // an unknown type or an ID that is not 22 base62 digits; write it as text then.
+    static bool Encode(const String& uri, byte out[SIZE]);
+    // Decodes into "type:id", without the "spotify:" prefix. False if data is not a valid compact URI.
+    static bool Decode(const byte* data, size_t len, String& uri);
+    static bool IsCompact(const byte* data, size_t len) { return len > 0 && (data[0] & 0xF0) == 0xC0; }
+
+private:
+    // CRC_A as the RC522 computes it (ISO 14443-3: reflected 0x1021, preset 0x6363), low byte first.
+    // Kept here because the sketches carry their own MFRC522 copies, which this library cannot include.
+    static void Crc(const byte* data, byte len, byte out[2]);
+
+    static const char* const TYPES[];
+    static const byte TYPE_COUNT;
+    static const char ALPHABET[];
+};
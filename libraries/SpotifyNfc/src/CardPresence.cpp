@@ -0,0 +1,55 @@
+#include "CardPresence.h"
+
+CardPresence::CardPresence(MFRC522& reader, byte missesToRemove) : mfrc522(reader), missesToRemove(missesToRemove) {
+}
+
+CardPresence::Event CardPresence::Poll() {
+    // Cards in IDLE answer REQA. The resting card is halted, so this is a new card,
+    // unless the resting one fell back to IDLE (for example after a field dropout).
+    if (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial()) {
+        if (present && IsRestingCard()) {
+            mfrc522.PICC_HaltA();
+            misses = 0;
+            return NONE;
+        }
+        memcpy(uid, mfrc522.uid.uidByte, mfrc522.uid.size);
+        uidSize = mfrc522.uid.size;
+        present = true;
+        misses = 0;
+        return NEW_CARD;
+    }
+
+    if (!present) return NONE;
+
+    // WUPA also wakes halted cards: check the resting card is still there and put it back to sleep
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    if (mfrc522.PICC_WakeupA(atqa, &atqaSize) == MFRC522::STATUS_OK && mfrc522.PICC_ReadCardSerial()) {
+        if (IsRestingCard()) {
+            mfrc522.PICC_HaltA();
+            misses = 0;
+            return NONE;
+        }
+        // Another card answered in its place
+        memcpy(uid, mfrc522.uid.uidByte, mfrc522.uid.size);
+        uidSize = mfrc522.uid.size;
+        misses = 0;
+        return NEW_CARD;
+    }
+
+    if (++misses >= missesToRemove) {
+        present = false;
+        misses = 0;
+        return REMOVED;
+    }
+    return NONE;
+}
+
+void CardPresence::Rest() {
+    mfrc522.PICC_HaltA();
+    mfrc522.PCD_StopCrypto1();
+}
+
+bool CardPresence::IsRestingCard() const {
+    return mfrc522.uid.size == uidSize && memcmp(mfrc522.uid.uidByte, uid, uidSize) == 0;
+}
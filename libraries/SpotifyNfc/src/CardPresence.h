@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+#include "MFRC522.h"
+
+// Tells a new card from one still resting on the reader, so the reader can be polled quickly.
+// A card that has been read is put in HALT. It then ignores REQA, so PICC_IsNewCardPresent() only
+// sees new cards, while WUPA still wakes it to check it has not been taken away.
+class CardPresence {
+public:
+    enum Event {
+        NONE,       // Nothing changed
+        NEW_CARD,   // A card arrived; it is selected and mfrc522.uid holds its UID
+        REMOVED     // The resting card left the field
+    };
+
+    CardPresence(MFRC522& reader, byte missesToRemove = 2);
+
+    Event Poll();                       // Call every loop
+    void Rest();                        // Call when done with a NEW_CARD; halts it
+    bool IsCardPresent() const { return present; }
+
+private:
+    MFRC522& mfrc522;
+    byte missesToRemove;                // Failed wake-ups in a row before the card counts as removed
+    byte misses = 0;
+    bool present = false;
+    byte uid[10];
+    byte uidSize = 0;
+
+    bool IsRestingCard() const;         // True if mfrc522.uid is the resting card
+};
@@ -0,0 +1,133 @@
+#include "NdefStream.h"
+
+NdefStream::NdefStream(MFRC522& reader) : mfrc522(reader) {
+}
+
+bool NdefStream::Start() {
+    // One READ returns pages 3 to 6: the capability container and the first 12 data bytes
+    page = 3;
+    position = 12;
+    blockOffset = 16;
+    dataEnd = 16;
+    bytesRead = 0;
+    readError = false;
+    malformed = false;
+    byte cc[4];
+    for (byte i = 0; i < 4; i++) {
+        if (!Next(cc[i])) return false;
+    }
+    // E1 = NDEF, version 1.x, data area size in units of 8 bytes, read access 0 = free
+    if (cc[0] != 0xE1 || (cc[1] >> 4) != 1 || (cc[3] >> 4) != 0) return false;
+    dataEnd = 16 + cc[2] * 8;
+    return true;
+}
+
+bool NdefStream::Next(byte& value) {
+    if (position >= dataEnd || readError) return false;
+    if (blockOffset >= 16) {
+        byte buffer[18];
+        byte size = sizeof(buffer);
+        if (mfrc522.MIFARE_Read(page, buffer, &size) != MFRC522::STATUS_OK) {
+            readError = true;
+            return false;
+        }
+        memcpy(block, buffer, 16);
+        page += 4;
+        blockOffset = 0;
+        bytesRead += 16;
+    }
+    value = block[blockOffset++];
+    position++;
+    return true;
+}
+
+bool NdefStream::Skip(uint32_t count) {
+    // Whole READs that are skipped entirely are not sent
+    while (count > 0) {
+        if (blockOffset >= 16 && count >= 16) {
+            if ((uint32_t)position + 16 > dataEnd) return false;
+            page += 4;
+            position += 16;
+            count -= 16;
+            continue;
+        }
+        byte value;
+        if (!Next(value)) return false;
+        count--;
+    }
+    return true;
+}
+
+NdefStream::Result NdefStream::FindSpotifyUri(char* out, size_t outSize) {
+    if (outSize > 0) out[0] = '\0';
+    if (!Start()) return readError ? READ_ERROR : NOT_NDEF;
+
+    bool foundMessage = false;
+    byte tag;
+    while (Next(tag)) {
+        if (tag == 0x00) continue;              // NULL TLV
+        if (tag == 0xFE) break;                 // Terminator TLV
+        byte lengthByte;
+        if (!Next(lengthByte)) break;
+        uint32_t length = lengthByte;
+        if (lengthByte == 0xFF) {               // Three byte length format
+            byte high, low;
+            if (!Next(high) || !Next(low)) break;
+            length = (high << 8) | low;
+        }
+        if (tag == 0x03) {                      // NDEF Message TLV
+            foundMessage = true;
+            Result result = FindInMessage(length, out, outSize);
+            if (result != NOT_FOUND || malformed) return result;
+        } else if (!Skip(length)) {             // Lock and memory control TLVs, proprietary TLVs
+            break;
+        }
+    }
+    if (readError) return READ_ERROR;
+    return foundMessage ? NOT_FOUND : NOT_NDEF;
+}
+
+NdefStream::Result NdefStream::FindInMessage(uint32_t length, char* out, size_t outSize) {
+    // Everything read below counts against the TLV length, so a record cannot run into the next TLV
+    const uint32_t end = position + length;
+    byte type[MAX_TYPE];
+    byte payload[MAX_PAYLOAD];
+
+    while (position < end) {
+        byte header, typeLength, idLength = 0;
+        if (!Next(header) || !Next(typeLength)) break;
+        uint32_t payloadLength = 0;
+        byte lengthBytes = (header & 0x10) ? 1 : 4;     // SR: one byte payload length
+        for (byte i = 0; i < lengthBytes; i++) {
+            byte value;
+            if (!Next(value)) return readError ? READ_ERROR : NOT_FOUND;
+            payloadLength = (payloadLength << 8) | value;
+        }
+        if ((header & 0x08) && !Next(idLength)) break;   // IL: ID length present
+        if ((uint32_t)position + typeLength + idLength + payloadLength > end) {
+            malformed = true;                       // The bytes after the TLV are no records, stop reading
+            return NOT_FOUND;
+        }
+
+        // Chunked records (CF) are never Spotify URIs. Only short ones are read into the buffers.
+        bool wanted = !(header & 0x20) && typeLength <= MAX_TYPE && payloadLength <= MAX_PAYLOAD;
+        if (wanted) {
+            for (byte i = 0; i < typeLength; i++) {
+                if (!Next(type[i])) return readError ? READ_ERROR : NOT_FOUND;
+            }
+            if (!Skip(idLength)) break;
+            for (uint32_t i = 0; i < payloadLength; i++) {
+                if (!Next(payload[i])) return readError ? READ_ERROR : NOT_FOUND;
+            }
+            if (SpotifyNdef::FromRecord(header & 0x07, type, typeLength, payload, payloadLength, out, outSize)) {
+                return FOUND;                       // Done, the rest of the tag is never read
+            }
+        } else if (!Skip((uint32_t)typeLength + idLength + payloadLength)) {
+            break;
+        }
+        if (header & 0x40) break;                   // ME: last record of the message
+    }
+    if (readError) return READ_ERROR;
+    if (position < end) Skip(end - position);      // On to the next TLV
+    return readError ? READ_ERROR : NOT_FOUND;
+}
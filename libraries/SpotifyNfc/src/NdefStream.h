@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include "MFRC522.h"
+#include "SpotifyNdef.h"
+
+// Finds the first Spotify URI on an NFC Forum Type 2 tag (NTAG21x, Ultralight) while reading it.
+// NfcAdapter::read() reads the whole tag and builds every record before the first one can be looked at.
+// This reads 4 pages per READ, parses the capability container, the TLVs and the records as the bytes
+// arrive, and stops at the first record SpotifyNdef accepts. A URI near the start of a large tag then
+// costs no more than on a small one. Records are only buffered while they are short enough to hold a URI.
+class NdefStream {
+public:
+    enum Result {
+        FOUND,          // out holds the URI
+        NOT_FOUND,      // NDEF, but no Spotify URI (or a malformed message)
+        NOT_NDEF,       // No NDEF capability container, or no NDEF message TLV
+        READ_ERROR      // A READ failed, the tag probably left the field
+    };
+
+    NdefStream(MFRC522& reader);
+
+    // Reads the selected tag. Call after PICC_ReadCardSerial() on a tag of type PICC_TYPE_MIFARE_UL.
+    Result FindSpotifyUri(char* out, size_t outSize);
+    uint16_t GetBytesRead() const { return bytesRead; }    // Bytes read from the tag by the last call
+
+private:
+    static const byte MAX_TYPE = 8;       // Longer record types are never 'T' or 'U'
+    static const byte MAX_PAYLOAD = 255;  // Short records only; a longer payload is no URI
+
+    MFRC522& mfrc522;
+    byte block[16];                 // Pages page-4 .. page-1
+    byte blockOffset = 16;          // Next byte in block, 16 = read the next 4 pages
+    byte page = 0;                  // First page of the next READ
+    uint16_t position = 0;          // Tag byte offset of the next byte
+    uint16_t dataEnd = 0;           // End of the data area, from the capability container
+    uint16_t bytesRead = 0;
+    bool readError = false;
+    bool malformed = false;         // A record did not fit its message, nothing after it can be trusted
+
+    bool Start();                              // Reads the capability container
+    bool Next(byte& value);                    // Next byte of the data area, false at its end or on errors
+    bool Skip(uint32_t count);
+    Result FindInMessage(uint32_t length, char* out, size_t outSize);
+};
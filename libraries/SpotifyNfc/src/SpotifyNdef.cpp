@@ -0,0 +1,120 @@
+#include "SpotifyNdef.h"
+
+// NFC Forum URI Record Type Definition, section 3.2.2. The index is the code in the first payload byte.
+const char* const SpotifyNdef::URI_PREFIXES[] = {
+    "", "http://www.", "https://www.", "http://", "https://", "tel:", "mailto:",
+    "ftp://anonymous:anonymous@", "ftp://ftp.", "ftps://", "sftp://", "smb://", "nfs://", "ftp://", "dav://",
+    "news:", "telnet://", "imap:", "rtsp://", "urn:", "pop:", "sip:", "sips:", "tftp:", "btspp://",
+    "btl2cap://", "btgoep://", "tcpobex://", "irdaobex://", "file://", "urn:epc:id:", "urn:epc:tag:",
+    "urn:epc:pat:", "urn:epc:raw:", "urn:epc:", "urn:nfc:"
+};
+const byte SpotifyNdef::URI_PREFIX_COUNT = sizeof(URI_PREFIXES) / sizeof(URI_PREFIXES[0]);
+
+bool SpotifyNdef::StartsWith(View text, const char* prefix) {
+    size_t len = strlen(prefix);
+    return text.len >= len && memcmp(text.data, prefix, len) == 0;
+}
+
+SpotifyNdef::View SpotifyNdef::Skip(View text, size_t count) {
+    if (count > text.len) count = text.len;
+    return View{ text.data + count, text.len - count };
+}
+
+bool SpotifyNdef::TextOf(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen, View& text) {
+    if (tnf != TNF_WELL_KNOWN || typeLen != 1 || type == nullptr || type[0] != 'T') return false;
+    if (payload == nullptr || payloadLen < 1) return false;
+    size_t langLen = payload[0] & 0x3F;     // Bit 7 is UTF-16, which Spotify URIs never need
+    if (payload[0] & 0x80) return false;
+    if (1 + langLen > payloadLen) return false;
+    text = View{ payload + 1 + langLen, payloadLen - 1 - langLen };
+    return true;
+}
+
+bool SpotifyNdef::UriOf(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen,
+                        const char*& prefix, View& rest) {
+    if (tnf != TNF_WELL_KNOWN || typeLen != 1 || type == nullptr || type[0] != 'U') return false;
+    if (payload == nullptr || payloadLen < 1 || payload[0] >= URI_PREFIX_COUNT) return false;
+    prefix = URI_PREFIXES[payload[0]];
+    rest = View{ payload + 1, payloadLen - 1 };
+    return true;
+}
+
+bool SpotifyNdef::Normalize(View text, char* out, size_t outSize) {
+    if (outSize == 0) return false;
+    out[0] = '\0';
+
+    // Up to the query or fragment, without the padding some writers leave at the end
+    size_t end = 0;
+    while (end < text.len && text.data[end] != '?' && text.data[end] != '#' && text.data[end] != '\0') end++;
+    while (end > 0 && (text.data[end - 1] == ' ' || text.data[end - 1] == '\r' || text.data[end - 1] == '\n' ||
+                       text.data[end - 1] == '/')) end--;
+    text.len = end;
+
+    static const char* const LINKS[] = { "https://open.spotify.com/", "http://open.spotify.com/", "open.spotify.com/" };
+    size_t len = 0;
+    bool link = false;
+    for (const char* prefix : LINKS) {
+        if (StartsWith(text, prefix)) {
+            text = Skip(text, strlen(prefix));
+            link = true;
+            break;
+        }
+    }
+    if (link) {
+        if (StartsWith(text, "intl-")) {   // Localized links: open.spotify.com/intl-de/album/ID
+            const byte* slash = (const byte*)memchr(text.data, '/', text.len);
+            if (slash == nullptr) return false;
+            text = Skip(text, slash + 1 - text.data);
+        }
+        memcpy(out, "spotify:", 8);
+        len = 8;
+    } else if (!StartsWith(text, "spotify:")) {
+        return false;
+    }
+
+    if (len + text.len + 1 > outSize) {
+        out[0] = '\0';
+        return false;
+    }
+    for (size_t i = 0; i < text.len; i++) {
+        char c = text.data[i];
+        if (c <= ' ' || c > '~') {
+            out[0] = '\0';
+            return false;                  // Not a URI: control characters, spaces or non-ASCII
+        }
+        out[len++] = (link && c == '/') ? ':' : c;
+    }
+    out[len] = '\0';
+    return len > 8;
+}
+
+bool SpotifyNdef::FromRecord(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen,
+                             char* out, size_t outSize) {
+    View text;
+    const char* prefix;
+    if (outSize > 0) out[0] = '\0';
+    if (TextOf(tnf, type, typeLen, payload, payloadLen, text)) return Normalize(text, out, outSize);
+    if (!UriOf(tnf, type, typeLen, payload, payloadLen, prefix, text)) return false;
+    // Only "spotify:..." and open.spotify.com links are of interest. Normalize() takes the link without
+    // its scheme, so the abbreviation never has to be copied in front of the rest.
+    if (prefix[0] == '\0') return Normalize(text, out, outSize);
+    if (strcmp(prefix, "https://") != 0 && strcmp(prefix, "http://") != 0) return false;
+    return StartsWith(text, "open.spotify.com/") && Normalize(text, out, outSize);
+}
+
+size_t SpotifyNdef::UriRecordPayload(const char* uri, byte* out, size_t outSize) {
+    byte code = 0;
+    size_t prefixLen = 0;
+    for (byte i = 1; i < URI_PREFIX_COUNT; i++) {
+        size_t len = strlen(URI_PREFIXES[i]);
+        if (len > prefixLen && strncmp(uri, URI_PREFIXES[i], len) == 0) {
+            code = i;
+            prefixLen = len;
+        }
+    }
+    size_t restLen = strlen(uri) - prefixLen;
+    if (1 + restLen > outSize) return 0;
+    out[0] = code;
+    memcpy(out + 1, uri + prefixLen, restLen);
+    return 1 + restLen;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+
+// Finds Spotify URIs in NDEF records without copying the payload or touching the heap.
+// The parsers hand out views into the record payload; the only output is a fixed char buffer.
+// Every length read from the tag is checked against the payload before it is used.
+class SpotifyNdef {
+public:
+    static const size_t URI_SIZE = 128;    // Buffer for a URI, with the terminating zero
+
+    // A slice of a payload. Not zero terminated, only valid while the payload is.
+    struct View {
+        const byte* data;
+        size_t len;
+    };
+
+    static const byte TNF_WELL_KNOWN = 0x01;
+
+    // The text of a Well-Known Text ('T') record: status byte, language code, text.
+    // False if the record is not a text record or the language code runs past the payload.
+    static bool TextOf(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen, View& text);
+    // The URI of a Well-Known URI ('U') record: the abbreviation its first byte stands for (NFC Forum
+    // URI RTD, codes 0x00-0x23, "" for none) and the rest of the payload. False if the record is not a
+    // URI record or the code is reserved.
+    static bool UriOf(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen,
+                      const char*& prefix, View& rest);
+    // "spotify:album:ID" stays as it is, "https://open.spotify.com/album/ID?si=..." (also with an
+    // intl-xx segment) becomes "spotify:album:ID". Query and fragment are dropped. False, with out
+    // empty, if text is neither or the URI does not fit in outSize.
+    static bool Normalize(View text, char* out, size_t outSize);
+    // TextOf() or UriOf(), then Normalize(): true if the record holds a Spotify URI, written to out.
+    static bool FromRecord(byte tnf, const byte* type, size_t typeLen, const byte* payload, size_t payloadLen,
+                           char* out, size_t outSize);
+    // The payload of a URI record for uri, abbreviated with the longest matching prefix code. A URI record
+    // needs no status byte or language code, so it is 3 bytes shorter than a text record with "en".
+    // Returns the payload length, 0 if it does not fit in outSize.
+    static size_t UriRecordPayload(const char* uri, byte* out, size_t outSize);
+
+private:
+    static const char* const URI_PREFIXES[];
+    static const byte URI_PREFIX_COUNT;
+
+    static bool StartsWith(View text, const char* prefix);
+    static View Skip(View text, size_t count);
+};
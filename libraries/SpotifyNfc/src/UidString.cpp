@@ -0,0 +1,12 @@
+#include "UidString.h"
+
+String uidString(const MFRC522::Uid& uid) {
+    String out;
+    for (byte i = 0; i < uid.size; i++) {
+        if (i > 0) out += ' ';
+        if (uid.uidByte[i] < 0x10) out += '0';
+        out += String(uid.uidByte[i], HEX);
+    }
+    out.toUpperCase();
+    return out;
+}
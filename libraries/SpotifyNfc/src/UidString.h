@@ -0,0 +1,6 @@
+#pragma once
+#include <Arduino.h>
+#include "MFRC522.h"
+
+// "04 A2 3B ..." like NfcTag::getUidString(), for tags read without NfcAdapter
+String uidString(const MFRC522::Uid& uid);